@@ -2,8 +2,29 @@
 #include <type_traits>
 #include <string>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+// SSSE3 and AVX2 kernels are compiled for x86 regardless of the compiler flags and selected at
+// runtime by the features of the CPU
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ZBIO_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <stdlib.h>
+#endif
+
+#if defined(ZBIO_HAS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define ZBIO_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ZBIO_TARGET(isa)
+#endif
+
 #define ZBIO_UNUSED(v) static_cast<void>(v)
 
 namespace ZBio {
@@ -30,4 +51,241 @@ inline void reverseEndianness<std::string>(std::string& str) {
     reverseEndianness(str.data(), str.size());
 }
 
-} // namespace ZBio
\ No newline at end of file
+namespace detail {
+
+inline uint16_t byteSwap(uint16_t v) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_ushort(v);
+#else
+    return __builtin_bswap16(v);
+#endif
+}
+
+inline uint32_t byteSwap(uint32_t v) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_ulong(v);
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+inline uint64_t byteSwap(uint64_t v) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+template <size_t Size>
+using UintOfSize = std::conditional_t<Size == 2,
+                                      uint16_t,
+                                      std::conditional_t<Size == 4, uint32_t, uint64_t>>;
+
+// Instruction sets byteSwapArray can use, each one implies the ones before
+enum class SimdLevel { Scalar, SSSE3, AVX2 };
+
+// Best instruction set supported by the compiler flags or, on x86, the running CPU
+inline SimdLevel simdLevel() noexcept {
+#if defined(__AVX2__)
+    return SimdLevel::AVX2;
+#elif defined(ZBIO_HAS_X86_SIMD)
+    static const SimdLevel level = [] {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const auto maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool ssse3 = info[2] & (1 << 9);
+        // AVX2 needs the OS to save the YMM registers as well
+        const bool osYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+        bool avx2 = false;
+        if(maxLeaf >= 7 && osYmm) {
+            __cpuidex(info, 7, 0);
+            avx2 = info[1] & (1 << 5);
+        }
+#else
+        __builtin_cpu_init();
+        const bool ssse3 = __builtin_cpu_supports("ssse3");
+        const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        return avx2 ? SimdLevel::AVX2 : ssse3 ? SimdLevel::SSSE3 : SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+#ifdef ZBIO_HAS_X86_SIMD
+// Shuffle mask reversing each ElementSize-byte group of a 16 byte lane
+template <size_t ElementSize, size_t Bytes>
+constexpr std::array<char, Bytes> byteSwapMask() noexcept {
+    std::array<char, Bytes> mask{};
+    for(size_t i = 0; i < Bytes; ++i) {
+        const auto lane = i % 16;
+        const auto element = lane - lane % ElementSize;
+        mask[i] = static_cast<char>(element + ElementSize - 1 - lane % ElementSize);
+    }
+    return mask;
+}
+
+// Swap whole vectors of the first 'bytes' bytes, return the number of bytes swapped
+template <size_t ElementSize>
+ZBIO_TARGET("ssse3")
+inline size_t byteSwapSSSE3(char* data, size_t bytes) noexcept {
+    alignas(16) static constexpr auto mask = byteSwapMask<ElementSize, 16>();
+    const auto shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(mask.data()));
+    size_t i = 0;
+    for(; i + 16 <= bytes; i += 16) {
+        const auto p = reinterpret_cast<__m128i*>(data + i);
+        _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle));
+    }
+    return i;
+}
+
+template <size_t ElementSize>
+ZBIO_TARGET("avx2")
+inline size_t byteSwapAVX2(char* data, size_t bytes) noexcept {
+    alignas(32) static constexpr auto mask256 = byteSwapMask<ElementSize, 32>();
+    alignas(16) static constexpr auto mask128 = byteSwapMask<ElementSize, 16>();
+    const auto shuffle256 = _mm256_load_si256(reinterpret_cast<const __m256i*>(mask256.data()));
+    const auto shuffle128 = _mm_load_si128(reinterpret_cast<const __m128i*>(mask128.data()));
+    size_t i = 0;
+    for(; i + 32 <= bytes; i += 32) {
+        const auto p = reinterpret_cast<__m256i*>(data + i);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle256));
+    }
+    for(; i + 16 <= bytes; i += 16) {
+        const auto p = reinterpret_cast<__m128i*>(data + i);
+        _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle128));
+    }
+    return i;
+}
+#endif
+
+// Reverse the byte order of 'count' consecutive ElementSize-byte elements in place. Vectorized
+// with AVX2 or SSSE3 shuffles up to 'level', the remainder is swapped element by element.
+template <size_t ElementSize>
+inline void byteSwapArray(char* data, size_t count, SimdLevel level) noexcept {
+    static_assert(ElementSize == 2 || ElementSize == 4 || ElementSize == 8);
+
+    const size_t bytes = count * ElementSize;
+    size_t i = 0;
+#ifdef ZBIO_HAS_X86_SIMD
+    // Short arrays aren't worth the call into a kernel
+    if(bytes >= 16 && level == SimdLevel::AVX2)
+        i = byteSwapAVX2<ElementSize>(data, bytes);
+    else if(bytes >= 16 && level == SimdLevel::SSSE3)
+        i = byteSwapSSSE3<ElementSize>(data, bytes);
+#else
+    ZBIO_UNUSED(level);
+#endif
+    for(; i < bytes; i += ElementSize) {
+        UintOfSize<ElementSize> v;
+        memcpy(&v, data + i, ElementSize);
+        v = byteSwap(v);
+        memcpy(data + i, &v, ElementSize);
+    }
+}
+
+template <size_t ElementSize>
+inline void byteSwapArray(char* data, size_t count) noexcept {
+    byteSwapArray<ElementSize>(data, count, simdLevel());
+}
+
+// Reverse the byte order of a fundamental value or of each element of an array of them
+template <typename T>
+inline void byteSwapValue(T& value) noexcept {
+    if constexpr(std::is_array_v<T>) {
+        for(auto& element : value)
+            byteSwapValue(element);
+    } else if constexpr(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8) {
+        UintOfSize<sizeof(T)> v;
+        memcpy(&v, &value, sizeof(T));
+        v = byteSwap(v);
+        memcpy(&value, &v, sizeof(T));
+    } else if constexpr(sizeof(T) > 1) {
+        reverseEndianness(value);
+    }
+}
+
+template <typename MemberPtr>
+struct MemberPointer;
+
+template <typename C, typename M>
+struct MemberPointer<M C::*> {
+    using Class = C;
+    using Type = M;
+};
+
+} // namespace detail
+
+// Data member of a struct and the byte order it's stored in, see StructLayout
+template <auto Member, Endianness en = Endianness::LE>
+struct Field {
+    using Class = typename detail::MemberPointer<decltype(Member)>::Class;
+    using Type = typename detail::MemberPointer<decltype(Member)>::Type;
+    static_assert(std::is_fundamental_v<std::remove_all_extents_t<Type>>,
+                  "Fields must be fundamental types or arrays of them");
+
+    static constexpr auto member = Member;
+    static constexpr size_t size = sizeof(Type);
+    static constexpr Endianness endianness = en;
+
+    // Convert the field between its stored and the native byte order
+    template <typename T>
+    static void reverseEndianness(T& value) noexcept {
+        if constexpr(en == Endianness::BE)
+            detail::byteSwapValue(value.*Member);
+    }
+};
+
+// Fields of a struct with their byte order. Fields not listed, like byte arrays and padding, are
+// copied as stored.
+template <typename... Fields>
+struct Layout {
+    static constexpr bool hasBigEndianFields = ((Fields::endianness == Endianness::BE) || ...);
+
+    template <typename T>
+    static void reverseEndianness(T* arr, size_t count) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert((std::is_base_of_v<typename Fields::Class, T> && ...),
+                      "Field isn't a member of the struct");
+
+        if constexpr(hasBigEndianFields) {
+            for(size_t i = 0; i < count; ++i)
+                (Fields::reverseEndianness(arr[i]), ...);
+        }
+    }
+};
+
+// Describes how a trivially copyable struct is stored to read and write it, or arrays of it, with
+// one bulk copy followed by an in place swap of its big endian fields. Specialize it with a Layout
+// e.g.
+//     template <>
+//     struct StructLayout<Header>
+//     : Layout<Field<&Header::magic>, Field<&Header::size, Endianness::BE>> {};
+template <typename T>
+struct StructLayout;
+
+// Convert an array of structs between their stored and the native byte order, see StructLayout
+template <typename T>
+inline void reverseEndiannessStructs(T* arr, size_t count) noexcept {
+    StructLayout<T>::reverseEndianness(arr, count);
+}
+
+// Reverse the byte order of each element of an array of fundamental types
+template <typename T>
+inline void reverseEndiannessArray(T* arr, size_t count) noexcept {
+    static_assert(std::is_fundamental_v<T>);
+
+    if constexpr(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8) {
+        detail::byteSwapArray<sizeof(T)>(reinterpret_cast<char*>(arr), count);
+    } else if constexpr(sizeof(T) > 1) {
+        for(size_t i = 0; i < count; ++i)
+            reverseEndianness(arr[i]);
+    }
+}
+
+} // namespace ZBio
@@ -3,15 +3,45 @@
 #include "Common.h"
 
 #include <algorithm>
+#include <array>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define ZBIO_HAS_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ZBIO_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
 // Check if system is little endian
 static_assert(static_cast<const uint8_t&>(0x0B00B135) == 0x35);
 
@@ -19,6 +49,15 @@ namespace ZBio {
 
 namespace ZBinaryReader {
 
+// Expected access pattern of a range of a source, see ISource::advise
+enum class AccessHint {
+    Normal,
+    Sequential, // Range will be read front to back
+    Random,     // Range will be accessed in no particular order, read-ahead is wasted
+    WillNeed,   // Range will be read soon, start loading it
+    DontNeed    // Range won't be read again, cached data can be dropped
+};
+
 class ISource {
 public:
     virtual void read(char* dst, int64_t len) = 0;
@@ -27,268 +66,3403 @@ public:
     virtual int64_t tell() const noexcept = 0;
     virtual int64_t size() const noexcept = 0;
 
+    // Return an independent source over the same data with its own read head at tell().
+    // Sources that can't be cloned throw.
+    [[nodiscard]] virtual std::unique_ptr<ISource> clone() const;
+
+    // Return a source over [offset, offset + length) of this source's data, addressed relative to
+    // 'offset' and with its own read head at 0. The default wraps a clone() in a SliceSource.
+    [[nodiscard]] virtual std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const;
+
+    // Return a pointer to the bytes [offset, offset + len) if the source keeps them in memory for
+    // its whole lifetime, nullptr otherwise.
+    [[nodiscard]] virtual const char* contiguous(int64_t offset, int64_t len) const noexcept;
+
+    // Lend the bytes following the read head as window [ptr, ptr + n) and return n, without moving
+    // the read head. The window is valid until the next non-const call on the source. Sources that
+    // never lend windows return a negative value.
+    virtual int64_t lendWindow(const char*& ptr) noexcept;
+
+    // Hint how [offset, offset + len) will be accessed, len == 0 extends the range to the end of
+    // the source. Hints never affect the data read and sources are free to ignore them.
+    virtual void advise(int64_t offset, int64_t len, AccessHint hint) noexcept;
+
+    // Read [offset, offset + len) without moving the read head. The default seeks there and back,
+    // sources with positional access override it.
+    virtual void readAt(int64_t offset, char* dst, int64_t len);
+
     virtual ~ISource(){};
 };
 
+#ifdef ZBIO_HAS_POSIX_IO
+namespace detail {
+class FileDescriptor;
+} // namespace detail
+#endif
+
 class FileSource : public ISource {
 private:
+    std::filesystem::path path;
     int64_t size_;
     mutable std::ifstream ifs;
+#ifdef ZBIO_HAS_POSIX_IO
+    // Opened on first use by readAt and advise, the stream's descriptor isn't accessible and
+    // seeking it would discard its buffer
+    std::shared_ptr<const detail::FileDescriptor> positionalFile;
+
+    [[nodiscard]] const detail::FileDescriptor& descriptor();
+#endif
 
 public:
     explicit FileSource(const std::string& path);
     explicit FileSource(const char* path);
     explicit FileSource(const std::filesystem::path& path);
 
-    ~FileSource();
+    // Clones reopen the file
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    // Only WillNeed and DontNeed are honored, they act on the page cache which all handles share
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
 
     void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
     void peek(char* dst, int64_t len) const override;
-    void seek(int64_t offset) override final;
+    void seek(int64_t offset) override;
     [[nodiscard]] int64_t tell() const noexcept override final;
     [[nodiscard]] int64_t size() const noexcept override final;
 };
 
 class BufferSource : public ISource {
 private:
-    std::unique_ptr<char[]> ownedBuffer;
+    std::shared_ptr<const char[]> ownedBuffer; // Shared with clones and slices
 
     const char* buffer;
-    const int64_t bufferSize;
+    int64_t bufferSize;
     int64_t cur;
 
+protected:
+    // Shared ownership constructor, 'owner' keeps 'data' alive
+    BufferSource(std::shared_ptr<const char[]> owner, const char* data, int64_t data_size);
+
+    [[nodiscard]] const std::shared_ptr<const char[]>& owner() const noexcept;
+
 public:
     // Non owning constructor
     BufferSource(const char* data, int64_t data_size);
     // Owning constructor
     BufferSource(std::unique_ptr<char[]> data, int64_t data_size);
 
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    [[nodiscard]] std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const override;
+    [[nodiscard]] const char* contiguous(int64_t offset, int64_t len) const noexcept override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+
     void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
     void peek(char* dst, int64_t len) const override;
-    void seek(int64_t offset) override final;
+    void seek(int64_t offset) override;
     [[nodiscard]] int64_t tell() const noexcept override final;
     [[nodiscard]] int64_t size() const noexcept override final;
 };
 
-class BinaryReader;
+// Window of another source, see ISource::slice. Owns its parent and keeps the parent's read head
+// in sync with its own.
+class SliceSource : public ISource {
+private:
+    std::unique_ptr<ISource> parent;
+    int64_t base;
+    int64_t length;
+    int64_t cur;
+
+public:
+    SliceSource(std::unique_ptr<ISource> parent, int64_t offset, int64_t length);
 
-template <typename Source>
-class CoverageTrackingSource : public Source {
-    static_assert(std::is_base_of_v<ISource, Source>);
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    [[nodiscard]] std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const override;
+    [[nodiscard]] const char* contiguous(int64_t offset, int64_t len) const noexcept override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
 
-    std::vector<char> accessPattern; // TODO: replace with more space efficient, interval based, access pattern tracking
+// Source presenting an ordered list of sources, e.g. the shards of a split archive, as one
+// contiguous address space. Reads straddling part boundaries are split between the parts.
+class ConcatSource : public ISource {
+private:
+    std::vector<std::unique_ptr<ISource>> parts;
+    std::vector<int64_t> starts; // Offset of each part, followed by the total size
+    size_t part;                 // Part containing cur, parts.size() at the end
+    int64_t cur;
 
-    bool completeCoverageInternal() const;
+    static std::vector<std::unique_ptr<ISource>>
+    openParts(const std::vector<std::filesystem::path>& paths);
+    [[nodiscard]] size_t locate(int64_t offset) const noexcept;
 
 public:
-    template <typename... Args>
-    CoverageTrackingSource(Args&&... args);
+    explicit ConcatSource(std::vector<std::unique_ptr<ISource>> parts);
+    // Files are opened up front, in order
+    explicit ConcatSource(const std::vector<std::filesystem::path>& paths);
+
+    [[nodiscard]] size_t partCount() const noexcept;
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    // Ranges spanning several parts aren't contiguous
+    [[nodiscard]] const char* contiguous(int64_t offset, int64_t len) const noexcept override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+#ifdef ZBIO_HAS_POSIX_IO
+
+namespace detail {
+
+// Owning wrapper around a read-only POSIX file descriptor.
+class FileDescriptor {
+    int fd;
+
+public:
+    explicit FileDescriptor(const std::filesystem::path& path, int flags = 0);
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor(FileDescriptor&& other) noexcept;
+    ~FileDescriptor();
+
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(FileDescriptor&&) = delete;
+
+    [[nodiscard]] int get() const noexcept;
+    [[nodiscard]] int64_t size() const;
+
+    // Read up to 'len' bytes at 'offset'. Only returns less than 'len' bytes at end of file.
+    int64_t pread(char* dst, int64_t len, int64_t offset) const;
+
+    // Forward an access hint to the kernel, len == 0 extends to the end of the file
+    void advise(int64_t offset, int64_t len, AccessHint hint) const noexcept;
+};
+
+// Read-only mapping of a whole file. Empty files yield an empty mapping with a null data pointer.
+class FileMapping {
+    char* base;
+    int64_t length;
+
+public:
+    explicit FileMapping(const std::filesystem::path& path);
+    FileMapping(const FileMapping&) = delete;
+    FileMapping(FileMapping&& other) noexcept;
+    ~FileMapping();
+
+    FileMapping& operator=(const FileMapping&) = delete;
+    FileMapping& operator=(FileMapping&&) = delete;
+
+    [[nodiscard]] const char* data() const noexcept;
+    [[nodiscard]] int64_t size() const noexcept;
+};
+
+#ifdef ZBIO_HAS_IO_URING
+
+// Minimal io_uring submission/completion queue pair driven by raw syscalls. valid() returns false
+// if the kernel doesn't provide io_uring or refuses to set up the ring.
+class IoUring {
+    int ringFd;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+
+    void release() noexcept;
+
+public:
+    explicit IoUring(unsigned entries);
+    IoUring(const IoUring&) = delete;
+    ~IoUring();
+
+    IoUring& operator=(const IoUring&) = delete;
+
+    [[nodiscard]] bool valid() const noexcept;
+
+    // io_uring_enter, replaceable to inject failures in tests
+    using EnterFunction = long (*)(int ringFd, unsigned toSubmit, unsigned minComplete,
+                                   unsigned flags);
+    static long enterSyscall(int ringFd, unsigned toSubmit, unsigned minComplete,
+                             unsigned flags) noexcept;
+    static inline EnterFunction enter = &IoUring::enterSyscall;
+
+    // Queue and submit a vectored read of 'iov' at 'offset'. 'iov' has to outlive the request.
+    // If submitting fails the request is withdrawn from the queue before throwing.
+    void submitRead(int fd, const iovec* iov, int64_t offset, uint64_t userData);
+    // Block until a completion is available and return its user data and result.
+    std::pair<uint64_t, int32_t> waitCompletion();
+};
+
+#endif // ZBIO_HAS_IO_URING
+
+} // namespace detail
+
+// Source serving reads straight out of a read-only memory mapping of the file.
+// The mapping is shared with clones and slices and unmapped once the last of them is destroyed.
+class MmapSource : public BufferSource {
+private:
+    explicit MmapSource(const std::shared_ptr<const detail::FileMapping>& mapping);
+    MmapSource(std::shared_ptr<const char[]> owner, const char* data, int64_t data_size);
+
+public:
+    explicit MmapSource(const std::string& path);
+    explicit MmapSource(const char* path);
+    explicit MmapSource(const std::filesystem::path& path);
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    [[nodiscard]] std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+};
+
+// File source on a raw file descriptor that serves reads out of a read-ahead window and refills
+// it with large positional reads. Reads larger than the window bypass it. The window size adapts
+// to the access pattern: refills continuing the previous one double it, up to
+// maxAdaptiveWindowSize, others shrink it down to minAdaptiveWindowSize so random reads don't
+// fetch data that's never used.
+class BufferedFileSource : public ISource {
+public:
+    struct Stats {
+        AccessHint pattern; // Sequential or Random, as detected on the latest refill
+        int64_t windowSize; // Current read-ahead
+        uint64_t fills;
+        uint64_t sequentialFills;
+    };
+
+private:
+    std::shared_ptr<const detail::FileDescriptor> file; // Shared with clones
+    int64_t size_;
+
+    std::unique_ptr<char[]> window;
+    int64_t windowCapacity; // Allocated size of window
+    int64_t windowSize;     // Current read-ahead
+    int64_t minWindowSize;
+    int64_t maxWindowSize;
+    int64_t windowOffset; // File offset of window[0]
+    int64_t windowLength; // Number of valid bytes in window
+    int64_t cur;
+    int64_t sequentialEnd; // End of the latest read from the file
+    Stats stats_;
+
+    [[nodiscard]] bool inWindow(int64_t offset, int64_t len) const noexcept;
+    void adapt(int64_t offset) noexcept;
+    void fill(int64_t offset);
+
+    BufferedFileSource(std::shared_ptr<const detail::FileDescriptor> file, int64_t windowSize);
+
+public:
+    static constexpr int64_t defaultWindowSize = 0x10000;
+    static constexpr int64_t minAdaptiveWindowSize = 0x1000;
+    static constexpr int64_t maxAdaptiveWindowSize = 0x400000;
+
+    // 'windowSize' is the initial read-ahead, it's allowed to adapt beyond the default limits
+    explicit BufferedFileSource(const std::string& path, int64_t windowSize = defaultWindowSize);
+    explicit BufferedFileSource(const char* path, int64_t windowSize = defaultWindowSize);
+    explicit BufferedFileSource(const std::filesystem::path& path,
+                                int64_t windowSize = defaultWindowSize);
+
+    [[nodiscard]] Stats stats() const noexcept;
+
+    // Clones share the file descriptor but get their own read-ahead window
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+// Unbuffered file source issuing one positional read per request. All clones share a single
+// file descriptor and only own their read head, which makes cloned readers safe to use
+// concurrently from different threads.
+class PreadSource : public ISource {
+private:
+    std::shared_ptr<const detail::FileDescriptor> file;
+    int64_t base; // File offset of position 0, non zero for slices
+    int64_t size_;
+    int64_t cur;
+
+public:
+    explicit PreadSource(const std::string& path);
+    explicit PreadSource(const char* path);
+    explicit PreadSource(const std::filesystem::path& path);
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    [[nodiscard]] std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+// File source bypassing the page cache, for streaming scans which shouldn't evict other data.
+// The file is opened with O_DIRECT (F_NOCACHE on Apple platforms) and read in aligned blocks,
+// unaligned requests are served out of the current block. Filesystems rejecting direct I/O fall
+// back to regular reads which drop each block from the page cache after use.
+class DirectFileSource : public ISource {
+private:
+    struct AlignedFree {
+        void operator()(char* p) const noexcept;
+    };
+
+    std::shared_ptr<const detail::FileDescriptor> file; // Shared with clones
+    bool direct;
+    int64_t size_;
+
+    // The block is a cache, peeks may reload it
+    std::unique_ptr<char, AlignedFree> block;
+    int64_t blockSize;
+    mutable int64_t blockOffset; // File offset of block[0]
+    mutable int64_t blockLength; // Number of valid bytes in block
+    int64_t cur;
+
+    DirectFileSource(std::shared_ptr<const detail::FileDescriptor> file,
+                     bool direct,
+                     int64_t blockSize);
+
+    void fill(int64_t offset) const;
+    void copy(char* dst, int64_t offset, int64_t len) const;
+
+public:
+    // Alignment of offsets, lengths and buffers for direct I/O
+    static constexpr int64_t alignment = 0x1000;
+    static constexpr int64_t defaultBlockSize = 0x100000;
+
+    // 'blockSize' is rounded up to a multiple of 'alignment'
+    explicit DirectFileSource(const std::string& path, int64_t blockSize = defaultBlockSize);
+    explicit DirectFileSource(const char* path, int64_t blockSize = defaultBlockSize);
+    explicit DirectFileSource(const std::filesystem::path& path,
+                              int64_t blockSize = defaultBlockSize);
+
+    // Whether the page cache is actually bypassed or the fallback is used
+    [[nodiscard]] bool isDirect() const noexcept;
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+// Forward-only source over a file descriptor which can't seek, e.g. a pipe or stdin. Data is read
+// in chunks and the last 'lookback' bytes before the read head are kept, so peeks and short
+// backward seeks work. Seeks before the kept range throw. The size of a stream is unknown and
+// reported as -1, reads past its end throw like on any other source.
+class StreamSource : public ISource {
+private:
+    int fd; // Not owned
+    int64_t lookback;
+    int64_t chunkSize;
+    int64_t cur;
+
+    // Buffered bytes [bufferOffset, bufferOffset + bufferLength) of the stream, refilled by peeks
+    mutable std::vector<char> buffer;
+    mutable int64_t bufferOffset;
+    mutable int64_t bufferLength;
+    mutable bool eof;
+
+    void fill(int64_t end) const;
+
+public:
+    static constexpr int64_t defaultLookback = 0x10000;
+    static constexpr int64_t defaultChunkSize = 0x100000;
+
+    // The descriptor has to stay open for the lifetime of the source
+    explicit StreamSource(int fd,
+                          int64_t lookback = defaultLookback,
+                          int64_t chunkSize = defaultChunkSize);
+
+    int64_t lendWindow(const char*& ptr) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+#ifdef ZBIO_HAS_IO_URING
+
+// Asynchronous file source for large sequential scans. The file is read in fixed size blocks and
+// up to 'queueDepth' blocks ahead of the read head are kept in flight with io_uring. Reads are
+// served from blocks that already landed. Falls back to synchronous block reads if io_uring is
+// unavailable.
+class UringFileSource : public ISource {
+private:
+    enum class BlockState { Empty, InFlight, Ready };
+
+    struct Block {
+        int64_t index;
+        int64_t length;
+        BlockState state;
+        iovec iov;
+    };
+
+    std::shared_ptr<const detail::FileDescriptor> file;
+    int64_t size_;
+    int64_t blockSize;
+    int64_t cur;
+
+    std::unique_ptr<char[]> buffers;
+    std::vector<Block> blocks;
+    std::unique_ptr<detail::IoUring> ring;
+    unsigned inFlight;
+
+    UringFileSource(std::shared_ptr<const detail::FileDescriptor> file,
+                    int64_t blockSize,
+                    unsigned queueDepth);
+
+    [[nodiscard]] int64_t blockLength(int64_t index) const noexcept;
+    [[nodiscard]] const Block* findBlock(int64_t index) const noexcept;
+    void reap();
+    void schedule(int64_t index);
+    const Block& acquire(int64_t index);
+
+public:
+    static constexpr int64_t defaultBlockSize = 0x40000;
+    static constexpr unsigned defaultQueueDepth = 8;
+
+    explicit UringFileSource(const std::string& path,
+                             int64_t blockSize = defaultBlockSize,
+                             unsigned queueDepth = defaultQueueDepth);
+    explicit UringFileSource(const char* path,
+                             int64_t blockSize = defaultBlockSize,
+                             unsigned queueDepth = defaultQueueDepth);
+    explicit UringFileSource(const std::filesystem::path& path,
+                             int64_t blockSize = defaultBlockSize,
+                             unsigned queueDepth = defaultQueueDepth);
+    UringFileSource(const UringFileSource&) = delete;
+    ~UringFileSource();
+
+    UringFileSource& operator=(const UringFileSource&) = delete;
+
+    // Whether reads are actually queued through io_uring or the synchronous fallback is used.
+    [[nodiscard]] bool usesIoUring() const noexcept;
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
 
     void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
+
+#endif // ZBIO_HAS_IO_URING
+
+#endif // ZBIO_HAS_POSIX_IO
+
+// Thread safe LRU cache of fixed-size file blocks, keyed by file identity and block index, which
+// lets sources over the same files share data. Files modified in place while cached are only
+// detected through their size and modification time when a source is opened.
+class BlockCache {
+public:
+    // Identifies a version of a file independent of the path it was opened by
+    struct FileId {
+        uint64_t device;
+        uint64_t inode;
+        int64_t size;
+        int64_t modified; // Nanoseconds, in the file system's clock
+
+        bool operator==(const FileId& other) const noexcept;
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        int64_t bytes;  // Memory held by cached blocks
+        int64_t blocks; // Number of cached blocks
+    };
+
+    // Blocks stay valid while referenced, even after eviction
+    using Block = std::shared_ptr<const std::vector<char>>;
+
+    static constexpr int64_t defaultBlockSize = 0x10000;
+    static constexpr int64_t defaultCapacity = 0x4000000;
+
+    explicit BlockCache(int64_t capacity = defaultCapacity, int64_t blockSize = defaultBlockSize);
+
+    // Process-wide cache used by CachedSource unless another one is given
+    [[nodiscard]] static std::shared_ptr<BlockCache> global();
+    [[nodiscard]] static FileId identify(const std::filesystem::path& path);
+
+    [[nodiscard]] int64_t blockSize() const noexcept;
+    [[nodiscard]] int64_t capacity() const noexcept;
+
+    // Return the cached block or insert the one returned by 'load', which runs without holding
+    // the cache lock.
+    template <typename Load>
+    [[nodiscard]] Block get(const FileId& file, int64_t index, Load&& load);
+
+    [[nodiscard]] Stats stats() const;
+    void clear();
 
-    [[nodiscard]] static bool completeCoverage(const BinaryReader* br);
+private:
+    struct Key {
+        FileId file;
+        int64_t index;
+
+        bool operator==(const Key& other) const noexcept;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    using Entry = std::pair<Key, Block>;
+
+    mutable std::mutex mutex;
+    std::list<Entry> lru; // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries;
+    int64_t capacity_;
+    int64_t blockSize_;
+    int64_t bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    void evict();
 };
 
-class BinaryReader {
+// Source serving reads from a shared BlockCache. Missing blocks are loaded through the wrapped
+// source, which can be any source over the identified file.
+class CachedSource : public ISource {
+private:
     std::unique_ptr<ISource> source;
+    std::shared_ptr<BlockCache> cache;
+    BlockCache::FileId file;
+    int64_t size_;
+    int64_t cur;
+
+    // Block of the last access, pinned so it can be lent as window
+    mutable BlockCache::Block block;
+    mutable int64_t blockIndex;
+
+    const std::vector<char>& acquire(int64_t index) const;
+    void copy(char* dst, int64_t offset, int64_t len) const;
 
 public:
-    BinaryReader(BinaryReader& br) = delete;
-    BinaryReader(BinaryReader&& br) noexcept;
+    explicit CachedSource(const std::string& path,
+                          std::shared_ptr<BlockCache> cache = BlockCache::global());
+    explicit CachedSource(const char* path,
+                          std::shared_ptr<BlockCache> cache = BlockCache::global());
+    explicit CachedSource(const std::filesystem::path& path,
+                          std::shared_ptr<BlockCache> cache = BlockCache::global());
+    CachedSource(std::unique_ptr<ISource> source,
+                 const BlockCache::FileId& file,
+                 std::shared_ptr<BlockCache> cache = BlockCache::global());
+
+    [[nodiscard]] const std::shared_ptr<BlockCache>& getCache() const noexcept;
+
+    // Clones share the cache
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
 
-    explicit BinaryReader(const std::filesystem::path& path);
-    explicit BinaryReader(const std::string& path);
-    explicit BinaryReader(const char* path);
+// Source reading ahead on a dedicated I/O thread, so that waiting for the wrapped source overlaps
+// with parsing. The thread fills two blocks in turn while the reader consumes the other one,
+// blocks are handed over through atomic state flags and both threads only park when the other
+// one falls behind. Reads outside the read-ahead range restart it at the new position.
+class ReadAheadSource : public ISource {
+private:
+    enum class SlotState { Empty, Ready };
 
-    BinaryReader(const char* data, int64_t data_size);
-    BinaryReader(std::unique_ptr<char[]> data, int64_t data_size);
+    struct Slot {
+        std::unique_ptr<char[]> data;
+        int64_t offset = 0;
+        int64_t length = 0;
+        uint64_t generation = 0;
+        std::exception_ptr error; // Set if reading the block at 'offset' failed
+        std::atomic<SlotState> state{ SlotState::Empty };
+    };
 
-    explicit BinaryReader(std::unique_ptr<ISource> source);
+    std::unique_ptr<ISource> source; // Used by the I/O thread, guarded by sourceMutex
+    mutable std::mutex sourceMutex;
+    int64_t size_;
+    int64_t blockSize;
+    int64_t cur;
 
-    BinaryReader& operator=(const BinaryReader& br) = delete;
-    BinaryReader& operator=(BinaryReader&& br) noexcept;
+    // Slots are filled and consumed in the same cyclic order
+    mutable Slot slots[2];
+    mutable uint64_t consumed = 0; // Number of slots released by the reader
+    // Bumped by the reader to restart the read-ahead at requestOffset
+    mutable std::atomic<uint64_t> generation{ 0 };
+    mutable std::atomic<int64_t> requestOffset;
+    std::atomic<bool> stopping{ false };
 
-    [[nodiscard]] int64_t tell() const noexcept;
-    void seek(int64_t pos);
-    [[nodiscard]] int64_t size() const noexcept;
+    mutable std::mutex parkMutex;
+    mutable std::condition_variable parkCondition;
+    mutable std::atomic<int> parked{ 0 };
+    std::thread thread;
 
-    template <typename T, Endianness en = Endianness::LE>
-    void read(T* arr, int64_t len);
+    static constexpr int spinCount = 0x400;
 
-    template <typename T, Endianness en = Endianness::LE>
-    [[nodiscard]] T read();
+    template <typename Ready>
+    void park(Ready&& ready) const;
+    void wake() const;
+    void produce();
+    void release(Slot& slot) const;
+    const Slot& acquire(int64_t offset, bool consume) const;
+    void copy(char* dst, int64_t offset, int64_t len, bool consume) const;
 
-    template <typename T, Endianness en = Endianness::LE>
-    void peek(T* arr, int64_t len) const;
+public:
+    static constexpr int64_t defaultBlockSize = 0x100000;
 
-    template <typename T, Endianness en = Endianness::LE>
-    [[nodiscard]] T peek() const;
+    // Read-ahead starts at the current position of 'source'
+    explicit ReadAheadSource(std::unique_ptr<ISource> source, int64_t blockSize = defaultBlockSize);
+    explicit ReadAheadSource(const std::string& path, int64_t blockSize = defaultBlockSize);
+    explicit ReadAheadSource(const char* path, int64_t blockSize = defaultBlockSize);
+    explicit ReadAheadSource(const std::filesystem::path& path,
+                             int64_t blockSize = defaultBlockSize);
+    ~ReadAheadSource() override;
 
-    template <unsigned int len, Endianness en = Endianness::BE>
-    [[nodiscard]] std::string readString();
+    // The I/O thread refers to the source
+    ReadAheadSource(const ReadAheadSource&) = delete;
+    ReadAheadSource& operator=(const ReadAheadSource&) = delete;
 
-    template <Endianness en = Endianness::BE>
-    [[nodiscard]] std::string readString(size_t charCount);
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override;
 
-    template <Endianness en = Endianness::BE>
-    [[nodiscard]] std::string readCString();
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+    [[nodiscard]] int64_t tell() const noexcept override final;
+    [[nodiscard]] int64_t size() const noexcept override final;
+};
 
-    template <typename T>
-    void sink(int64_t len);
+// Read-only view of 'size()' elements of T. Either points into the memory of a source or owns a
+// copy of the data if the source couldn't expose it directly.
+template <typename T>
+class View {
+    static_assert(std::is_trivially_copyable_v<T>);
 
-    template <typename T>
-    void sink();
+    std::unique_ptr<T[]> owned;
+    const T* ptr;
+    size_t count;
 
-    template <unsigned int alignment = 0x10>
-    void align();
+public:
+    // Borrowing constructor
+    View(const T* data, size_t count) noexcept;
+    // Owning constructor
+    View(std::unique_ptr<T[]> data, size_t count) noexcept;
 
-    template <unsigned int alignment = 0x10>
-    void alignZeroPad();
+    [[nodiscard]] const T* data() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool isBorrowed() const noexcept;
 
-    [[nodiscard]] const ISource* getSource() const noexcept;
+    [[nodiscard]] const T* begin() const noexcept;
+    [[nodiscard]] const T* end() const noexcept;
+    [[nodiscard]] const T& operator[](size_t i) const noexcept;
 };
 
-inline FileSource::FileSource(const std::string& path) : FileSource(std::filesystem::path(path)) {
-}
+// Arena for strings read in bulk, see BasicBinaryReader::readString and readCString. Strings are
+// stored back to back in large chunks and returned as views, which stay valid until the pool is
+// cleared or destroyed. With deduplication repeated strings are stored once and share one view.
+class StringPool {
+    template <typename Source>
+    friend class BasicBinaryReader;
 
-inline FileSource::FileSource(const char* path) : FileSource(std::filesystem::path(path)) {
-}
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr; // Start of the pending string in the current chunk
+    char* chunkEnd = nullptr;
+    size_t pendingLen = 0;
+    size_t chunkSize;
+    bool deduplicate;
+    std::unordered_set<std::string_view> strings;
+    uint64_t interned = 0;
+    uint64_t stored = 0;
+    int64_t bytes = 0;
+    int64_t capacity = 0;
 
-inline FileSource::FileSource(const std::filesystem::path& path) : size_(0) {
-    if(!std::filesystem::exists(path) || !std::filesystem::is_regular_file(path))
-        throw std::runtime_error("Invalid path: " + path.generic_string());
+    // A string is built at the end of the current chunk and only committed by finishString, so
+    // reads go straight into the arena and duplicates are dropped without another copy.
+    void startString() noexcept;
+    [[nodiscard]] char* appendString(size_t len);
+    [[nodiscard]] char* pendingString() noexcept;
+    std::string_view finishString();
 
-    size_ = static_cast<uint64_t>(std::filesystem::file_size(path));
+public:
+    struct Stats {
+        uint64_t strings; // Strings interned
+        uint64_t unique;  // Strings stored, duplicates only count once
+        int64_t bytes;    // Bytes of the stored strings
+        int64_t capacity; // Bytes allocated for chunks
+    };
 
-    ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    ifs.open(path.generic_string());
-}
+    static constexpr size_t defaultChunkSize = 0x10000;
 
-inline FileSource::~FileSource() {
-    if(ifs.is_open())
-        ifs.close();
-}
+    explicit StringPool(bool deduplicate = true, size_t chunkSize = defaultChunkSize);
+    StringPool(const StringPool&) = delete;
+    StringPool(StringPool&& other) noexcept;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool& operator=(StringPool&& other) noexcept;
 
-inline void FileSource::read(char* dst, int64_t len) {
-    ifs.read(dst, len);
-}
+    // Copy 'str' into the pool, or return the stored copy if it's a duplicate
+    std::string_view intern(std::string_view str);
 
-inline void FileSource::peek(char* dst, int64_t len) const {
-    auto o = tell();
-    ifs.read(dst, len);
-    ifs.seekg(o, std::ios::beg);
-}
+    [[nodiscard]] bool deduplicates() const noexcept;
+    [[nodiscard]] Stats stats() const noexcept;
+    // Release all strings, views returned before become dangling
+    void clear() noexcept;
+};
 
-inline void FileSource::seek(int64_t offset) {
-    ifs.seekg(offset, std::ios::beg);
+namespace detail {
+
+// Storage for the source of a BasicBinaryReader. Concrete sources are held by value so calls into
+// them are statically dispatched, ISource is held through an owning pointer for type erasure.
+template <typename Source>
+class SourceHolder {
+    mutable Source source; // Shallow constness, like the owning pointer of the type erased holder
+
+public:
+    template <typename DefaultSource, typename... Args>
+    explicit SourceHolder(std::in_place_type_t<DefaultSource>, Args&&... args);
+    explicit SourceHolder(std::unique_ptr<Source> source);
+
+    [[nodiscard]] Source* get() const noexcept;
+    [[nodiscard]] Source* operator->() const noexcept;
+};
+
+template <>
+class SourceHolder<ISource> {
+    std::unique_ptr<ISource> source;
+
+public:
+    template <typename DefaultSource, typename... Args>
+    explicit SourceHolder(std::in_place_type_t<DefaultSource>, Args&&... args);
+    explicit SourceHolder(std::unique_ptr<ISource> source);
+
+    [[nodiscard]] ISource* get() const noexcept;
+    [[nodiscard]] ISource* operator->() const noexcept;
+};
+
+// Sets a flag for the lifetime of the guard. Mixins use it to ignore the reads and seeks a source
+// emulates positional reads with, see ISource::readAt.
+class FlagGuard {
+    bool& flag;
+
+public:
+    explicit FlagGuard(bool& flag) noexcept;
+    ~FlagGuard();
+
+    FlagGuard(const FlagGuard&) = delete;
+    FlagGuard& operator=(const FlagGuard&) = delete;
+};
+
+// Base of the mixins observing a source's operations. Direct memory access through windows and
+// contiguous() would bypass them and clones and slices would silently lose their state, so all of
+// these are disabled. Reads and views go through read() instead.
+template <typename Source>
+class OpaqueSourceMixin : public Source {
+    static_assert(std::is_base_of_v<ISource, Source>);
+
+public:
+    template <typename... Args>
+    OpaqueSourceMixin(Args&&... args);
+
+    [[nodiscard]] std::unique_ptr<ISource> clone() const override;
+    [[nodiscard]] std::unique_ptr<ISource> slice(int64_t offset, int64_t length) const override;
+    [[nodiscard]] const char* contiguous(int64_t offset, int64_t len) const noexcept override;
+    int64_t lendWindow(const char*& ptr) noexcept override;
+};
+
+} // namespace detail
+
+// Read of 'length' bytes at 'offset' into 'dst', see BasicBinaryReader::readBatch
+struct ReadRequest {
+    int64_t offset;
+    int64_t length;
+    char* dst;
+};
+
+template <typename Source>
+class BasicBinaryReader;
+
+// Type erased reader, works with any ISource implementation.
+using BinaryReader = BasicBinaryReader<ISource>;
+
+template <typename Source>
+class CoverageTrackingSource : public detail::OpaqueSourceMixin<Source> {
+
+    // Disjoint, non-adjacent [begin, end) ranges of read bytes, keyed by begin
+    std::map<int64_t, int64_t> coveredRanges;
+    bool inReadAt = false;
+
+    void markCovered(int64_t begin, int64_t end);
+    bool completeCoverageInternal() const;
+    std::vector<std::pair<int64_t, int64_t>> uncoveredRangesInternal() const;
+
+public:
+    template <typename... Args>
+    CoverageTrackingSource(Args&&... args);
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+
+    template <typename ReaderSource>
+    [[nodiscard]] static bool completeCoverage(const BasicBinaryReader<ReaderSource>* br);
+
+    // Return the [begin, end) ranges of the source which haven't been read yet, in ascending order
+    template <typename ReaderSource>
+    [[nodiscard]] static std::vector<std::pair<int64_t, int64_t>>
+    uncoveredRanges(const BasicBinaryReader<ReaderSource>* br);
+};
+
+// Call count, bytes moved and latency histogram of one source operation
+struct OperationMetrics {
+    static constexpr int bucketCount = 32;
+
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0; // Total time spent in the operation
+    // latency[i] counts calls that took [2^i, 2^(i+1)) ns, the first and last buckets are open
+    std::array<uint64_t, bucketCount> latency{};
+
+    void record(uint64_t byteCount, uint64_t ns) noexcept;
+};
+
+struct SourceMetrics {
+    OperationMetrics read;
+    OperationMetrics peek;
+    OperationMetrics seek; // 'bytes' holds the total seek distance
+    uint64_t backwardSeeks = 0;
+};
+
+// Mixin recording call counts, bytes, seek patterns and latencies of a source's reads, peeks and
+// seeks, e.g. to tell tiny reads, seek thrashing and slow devices apart.
+template <typename Source>
+class InstrumentedSource : public detail::OpaqueSourceMixin<Source> {
+
+    mutable SourceMetrics metrics_; // Peeks are const
+    bool inReadAt = false;
+
+    using Clock = std::chrono::steady_clock;
+    [[nodiscard]] static uint64_t elapsed(Clock::time_point start) noexcept;
+
+public:
+    template <typename... Args>
+    InstrumentedSource(Args&&... args);
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void peek(char* dst, int64_t len) const override;
+    void seek(int64_t offset) override;
+
+    [[nodiscard]] SourceMetrics getMetrics() const noexcept;
+    void resetMetrics() noexcept;
+
+    template <typename ReaderSource>
+    [[nodiscard]] static SourceMetrics metrics(const BasicBinaryReader<ReaderSource>* br);
+};
+
+// Ordered (offset, length) reads of a parse, with consecutive reads merged. Serializes to a compact
+// binary form storing each access as varints relative to the end of the previous one.
+class AccessTrace {
+public:
+    struct Access {
+        int64_t offset;
+        int64_t length;
+    };
+
+    AccessTrace() = default;
+    explicit AccessTrace(int64_t sourceSize) noexcept;
+
+    void record(int64_t offset, int64_t length);
+
+    [[nodiscard]] const std::vector<Access>& accesses() const noexcept;
+    // Size of the traced source, used to detect files with a different layout
+    [[nodiscard]] int64_t sourceSize() const noexcept;
+
+    [[nodiscard]] std::vector<char> serialize() const;
+    [[nodiscard]] static AccessTrace deserialize(const char* data, int64_t size);
+
+private:
+    static constexpr char magic[4] = { 'Z', 'B', 'T', '1' };
+
+    std::vector<Access> accesses_;
+    int64_t sourceSize_ = 0;
+};
+
+// Mixin recording the reads of a parse into an AccessTrace, see TracePrefetchSource
+template <typename Source>
+class TraceRecordingSource : public detail::OpaqueSourceMixin<Source> {
+
+    AccessTrace trace_;
+    bool inReadAt = false;
+
+public:
+    template <typename... Args>
+    TraceRecordingSource(Args&&... args);
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+
+    [[nodiscard]] const AccessTrace& getTrace() const noexcept;
+
+    template <typename ReaderSource>
+    [[nodiscard]] static AccessTrace trace(const BasicBinaryReader<ReaderSource>* br);
+};
+
+// Mixin replaying a recorded AccessTrace as WillNeed hints to the source, staying up to
+// 'lookahead' bytes of the trace ahead of the reads. This lets sources load the ranges of a
+// dependent chain of reads in parallel. Traces of sources with a different size are ignored.
+template <typename Source>
+class TracePrefetchSource : public detail::OpaqueSourceMixin<Source> {
+
+    // Reads are matched against the next few accesses of the trace only
+    static constexpr size_t searchDistance = 0x40;
+
+    AccessTrace trace;
+    std::vector<int64_t> traceBytes; // Accumulated access lengths, traceBytes[i] precedes access i
+    int64_t lookahead;
+    size_t current = 0;    // Access matching the latest read
+    size_t prefetched = 0; // Accesses before this one have been hinted
+
+    void progress(int64_t offset) noexcept;
+
+public:
+    static constexpr int64_t defaultLookahead = 0x1000000;
+
+    template <typename... Args>
+    TracePrefetchSource(AccessTrace trace, Args&&... args);
+
+    // Takes effect with the next read or seek
+    void setLookahead(int64_t bytes) noexcept;
+
+    void read(char* dst, int64_t len) override;
+    void readAt(int64_t offset, char* dst, int64_t len) override;
+    void seek(int64_t offset) override;
+};
+
+// Binary reader over a 'Source'. With a concrete source type the source is held by value and all
+// calls into it are statically dispatched and can be inlined, e.g. BasicBinaryReader<BufferSource>.
+// BasicBinaryReader<ISource>, aka BinaryReader, works with any source through virtual calls.
+template <typename Source>
+class BasicBinaryReader {
+    static_assert(std::is_base_of_v<ISource, Source>);
+
+    detail::SourceHolder<Source> source;
+
+    // Window lent by the source, see ISource::lendWindow. Small reads and peeks are served from it
+    // inline, the source is only called once it's exhausted. 'windowBase' is the source position
+    // of 'windowBegin'. The source's read head stays at 'windowBase' until the window is synced.
+    mutable const char* windowBegin = nullptr;
+    mutable const char* windowCur = nullptr;
+    mutable const char* windowEnd = nullptr;
+    mutable int64_t windowBase = 0;
+    mutable bool lendsWindows = true;
+
+    void refreshWindow() const noexcept;
+    void syncWindow() const;
+    static detail::SourceHolder<Source>&& releaseSource(BasicBinaryReader& br);
+
+    // Pass the pieces of the null terminated string at tell() to 'append' and move past it
+    template <typename Append>
+    void scanCString(Append&& append);
+
+public:
+    BasicBinaryReader(BasicBinaryReader& br) = delete;
+    BasicBinaryReader(BasicBinaryReader&& br) noexcept;
+
+    // File constructors, the type erased reader reads files through a FileSource
+    explicit BasicBinaryReader(const std::filesystem::path& path);
+    explicit BasicBinaryReader(const std::string& path);
+    explicit BasicBinaryReader(const char* path);
+
+    // Buffer constructors, the type erased reader reads buffers through a BufferSource
+    BasicBinaryReader(const char* data, int64_t data_size);
+    BasicBinaryReader(std::unique_ptr<char[]> data, int64_t data_size);
+
+    explicit BasicBinaryReader(std::unique_ptr<Source> source);
+
+    // Construct the source in place from 'args'
+    template <typename... Args>
+    explicit BasicBinaryReader(std::in_place_t, Args&&... args);
+
+    // Construct a reader over a 'SourceT' built from 'args'.
+    // e.g. BinaryReader::make<MmapSource>(path)
+    template <typename SourceT, typename... Args>
+    [[nodiscard]] static BasicBinaryReader make(Args&&... args);
+
+    BasicBinaryReader& operator=(const BasicBinaryReader& br) = delete;
+    BasicBinaryReader& operator=(BasicBinaryReader&& br) noexcept;
+
+    // Return an independent reader over the same source, positioned at tell().
+    [[nodiscard]] BasicBinaryReader clone() const;
+
+    // Return a reader over [offset, offset + length) of this reader's source. The slice shares the
+    // underlying buffer, mapping or file, addresses it relative to 'offset' and starts at 0.
+    [[nodiscard]] BinaryReader slice(int64_t offset, int64_t length) const;
+
+    // Hint how [offset, offset + len) will be accessed, len == 0 extends to the end of the source
+    void advise(AccessHint hint, int64_t offset = 0, int64_t len = 0) noexcept;
+    // Start loading [offset, offset + len) in the background, ahead of reading it
+    void prefetch(int64_t offset, int64_t len) noexcept;
+
+    [[nodiscard]] int64_t tell() const noexcept;
+    void seek(int64_t pos);
+    [[nodiscard]] int64_t size() const noexcept;
+
+    template <typename T, Endianness en = Endianness::LE>
+    void read(T* arr, int64_t len);
+
+    template <typename T, Endianness en = Endianness::LE>
+    [[nodiscard]] T read();
+
+    template <typename T, Endianness en = Endianness::LE>
+    void peek(T* arr, int64_t len) const;
+
+    template <typename T, Endianness en = Endianness::LE>
+    [[nodiscard]] T peek() const;
+
+    // Read structs described by a StructLayout with one bulk read, the fields stored big endian
+    // are swapped in place afterwards
+    template <typename T>
+    void readStruct(T* arr, int64_t len);
+
+    template <typename T>
+    [[nodiscard]] T readStruct();
+
+    // Positional reads, the read head doesn't move
+    template <typename T, Endianness en = Endianness::LE>
+    void readAt(int64_t offset, T* arr, int64_t len) const;
+
+    template <typename T, Endianness en = Endianness::LE>
+    [[nodiscard]] T readAt(int64_t offset) const;
+
+    // Return a view of the next 'count' elements and advance the read head. The view points
+    // directly into the source if it exposes contiguous memory, otherwise it holds a copy.
+    template <typename T = char>
+    [[nodiscard]] View<T> view(int64_t count);
+
+    // Perform many small reads with few positional source reads. Requests are sorted by offset,
+    // requests less than 'maxGap' bytes apart are served by one read and scattered into their
+    // destinations. The read head doesn't move.
+    void readBatch(const ReadRequest* requests,
+                   int64_t count,
+                   int64_t maxGap = defaultBatchGap);
+
+    template <unsigned int len, Endianness en = Endianness::BE>
+    [[nodiscard]] std::string readString();
+
+    template <Endianness en = Endianness::BE>
+    [[nodiscard]] std::string readString(size_t charCount);
+
+    template <Endianness en = Endianness::BE>
+    [[nodiscard]] std::string readCString();
+
+    // Read into 'pool' instead of allocating a string per read. The views stay valid as long as
+    // the pool, duplicates share one copy if the pool deduplicates.
+    template <Endianness en = Endianness::BE>
+    [[nodiscard]] std::string_view readString(size_t charCount, StringPool& pool);
+
+    template <Endianness en = Endianness::BE>
+    [[nodiscard]] std::string_view readCString(StringPool& pool);
+
+    // Zero-copy variants of readString and readCString returning the bytes as stored. The views
+    // point into the source's memory and stay valid as long as the source. Sources which don't
+    // expose contiguous memory, see ISource::contiguous, throw.
+    [[nodiscard]] std::string_view readStringView(size_t charCount);
+    [[nodiscard]] std::string_view readCStringView();
+
+    template <typename T>
+    void sink(int64_t len);
+
+    template <typename T>
+    void sink();
+
+    template <unsigned int alignment = 0x10>
+    void align();
+
+    template <unsigned int alignment = 0x10>
+    void alignZeroPad();
+
+    [[nodiscard]] const Source* getSource() const noexcept;
+
+    static constexpr int64_t defaultBatchGap = 0x1000;
+};
+
+inline std::unique_ptr<ISource> ISource::clone() const {
+    throw std::runtime_error("Source doesn't support cloning");
+}
+
+inline std::unique_ptr<ISource> ISource::slice(int64_t offset, int64_t length) const {
+    return std::make_unique<SliceSource>(clone(), offset, length);
+}
+
+inline const char* ISource::contiguous(int64_t offset, int64_t len) const noexcept {
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(len);
+    return nullptr;
+}
+
+inline int64_t ISource::lendWindow(const char*& ptr) noexcept {
+    ZBIO_UNUSED(ptr);
+    return -1;
+}
+
+inline void ISource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(len);
+    ZBIO_UNUSED(hint);
+}
+
+inline void ISource::readAt(int64_t offset, char* dst, int64_t len) {
+    const auto pos = tell();
+    seek(offset);
+    try {
+        read(dst, len);
+    } catch(...) {
+        seek(pos);
+        throw;
+    }
+    seek(pos);
+}
+
+inline FileSource::FileSource(const std::string& path) : FileSource(std::filesystem::path(path)) {
+}
+
+inline FileSource::FileSource(const char* path) : FileSource(std::filesystem::path(path)) {
+}
+
+inline FileSource::FileSource(const std::filesystem::path& path) : path(path), size_(0) {
+    if(!std::filesystem::exists(path) || !std::filesystem::is_regular_file(path))
+        throw std::runtime_error("Invalid path: " + path.generic_string());
+
+    size_ = static_cast<uint64_t>(std::filesystem::file_size(path));
+
+    ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    ifs.open(path.generic_string());
+}
+
+inline std::unique_ptr<ISource> FileSource::clone() const {
+    auto clone = std::make_unique<FileSource>(path);
+    clone->seek(tell());
+    return clone;
+}
+
+inline void FileSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+#ifdef ZBIO_HAS_POSIX_IO
+    // Page cache hints apply to every handle of a file, so the positional one serves as well
+    if(hint != AccessHint::WillNeed && hint != AccessHint::DontNeed)
+        return;
+    try {
+        descriptor().advise(offset, len, hint);
+    } catch(...) {
+    }
+#else
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(len);
+    ZBIO_UNUSED(hint);
+#endif
+}
+
+inline void FileSource::read(char* dst, int64_t len) {
+    ifs.read(dst, len);
+}
+
+inline void FileSource::readAt(int64_t offset, char* dst, int64_t len) {
+#ifdef ZBIO_HAS_POSIX_IO
+    if(offset < 0 || len < 0 || offset + len > size_)
+        throw std::runtime_error("OOR read/peek");
+    if(descriptor().pread(dst, len, offset) != len)
+        throw std::runtime_error("OOR read/peek");
+#else
+    ISource::readAt(offset, dst, len);
+#endif
+}
+
+#ifdef ZBIO_HAS_POSIX_IO
+inline const detail::FileDescriptor& FileSource::descriptor() {
+    if(!positionalFile)
+        positionalFile = std::make_shared<const detail::FileDescriptor>(path);
+    return *positionalFile;
+}
+#endif
+
+inline void FileSource::peek(char* dst, int64_t len) const {
+    auto o = tell();
+    ifs.read(dst, len);
+    ifs.seekg(o, std::ios::beg);
+}
+
+inline void FileSource::seek(int64_t offset) {
+    ifs.seekg(offset, std::ios::beg);
+}
+
+inline int64_t FileSource::tell() const noexcept {
+    return ifs.tellg();
+}
+
+inline int64_t FileSource::size() const noexcept {
+    return size_;
+}
+
+// Non owning constructor
+inline BufferSource::BufferSource(const char* data, int64_t data_size)
+: ownedBuffer(nullptr), buffer(data), bufferSize(data_size), cur(0) {
+}
+
+// Owning constructor
+inline BufferSource::BufferSource(std::unique_ptr<char[]> data, int64_t data_size)
+: ownedBuffer(std::move(data)), buffer(nullptr), bufferSize(data_size), cur(0) {
+    buffer = ownedBuffer.get();
+}
+
+// Shared ownership constructor
+inline BufferSource::BufferSource(std::shared_ptr<const char[]> owner,
+                                  const char* data,
+                                  int64_t data_size)
+: ownedBuffer(std::move(owner)), buffer(data), bufferSize(data_size), cur(0) {
+}
+
+inline const std::shared_ptr<const char[]>& BufferSource::owner() const noexcept {
+    return ownedBuffer;
+}
+
+inline std::unique_ptr<ISource> BufferSource::clone() const {
+    return std::make_unique<BufferSource>(*this);
+}
+
+inline std::unique_ptr<ISource> BufferSource::slice(int64_t offset, int64_t length) const {
+    if(offset < 0 || length < 0 || offset + length > bufferSize)
+        throw std::runtime_error("OOR slice");
+    return std::unique_ptr<ISource>(new BufferSource(ownedBuffer, buffer + offset, length));
+}
+
+inline const char* BufferSource::contiguous(int64_t offset, int64_t len) const noexcept {
+    if(offset < 0 || len < 0 || offset + len > bufferSize)
+        return nullptr;
+    return buffer + offset;
+}
+
+inline int64_t BufferSource::lendWindow(const char*& ptr) noexcept {
+    ptr = buffer + std::min(cur, bufferSize);
+    return std::max<int64_t>(bufferSize - cur, 0);
+}
+
+inline void BufferSource::read(char* dst, int64_t len) {
+    BufferSource::peek(dst, len);
+    cur += len;
+}
+
+inline void BufferSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > size())
+        throw std::runtime_error("OOR read/peek");
+    memcpy(dst, buffer + offset, len);
+}
+
+inline void BufferSource::peek(char* dst, int64_t len) const {
+    if(cur + len > size())
+        throw std::runtime_error("OOR read/peek");
+    memcpy(dst, &(buffer[cur]), len);
+}
+
+inline void BufferSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset; // Seeking to positive OOB is not an error
+}
+
+inline int64_t BufferSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t BufferSource::size() const noexcept {
+    return bufferSize;
+}
+
+inline SliceSource::SliceSource(std::unique_ptr<ISource> parent, int64_t offset, int64_t length)
+: parent(std::move(parent)), base(offset), length(length), cur(0) {
+    if(!this->parent || offset < 0 || length < 0 || offset + length > this->parent->size())
+        throw std::runtime_error("OOR slice");
+    this->parent->seek(base);
+}
+
+inline std::unique_ptr<ISource> SliceSource::clone() const {
+    auto clone = std::make_unique<SliceSource>(parent->clone(), base, length);
+    clone->seek(cur);
+    return clone;
+}
+
+// Slices of slices address the parent directly instead of nesting
+inline std::unique_ptr<ISource> SliceSource::slice(int64_t offset, int64_t length) const {
+    if(offset < 0 || length < 0 || offset + length > this->length)
+        throw std::runtime_error("OOR slice");
+    return std::make_unique<SliceSource>(parent->clone(), base + offset, length);
+}
+
+inline const char* SliceSource::contiguous(int64_t offset, int64_t len) const noexcept {
+    if(offset < 0 || len < 0 || offset + len > length)
+        return nullptr;
+    return parent->contiguous(base + offset, len);
+}
+
+inline int64_t SliceSource::lendWindow(const char*& ptr) noexcept {
+    const auto len = parent->lendWindow(ptr);
+    if(len < 0)
+        return len;
+    return std::max<int64_t>(std::min(len, length - cur), 0);
+}
+
+inline void SliceSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    if(offset < 0 || offset >= length)
+        return;
+    len = len ? std::min(len, length - offset) : length - offset;
+    parent->advise(base + offset, len, hint);
+}
+
+inline void SliceSource::read(char* dst, int64_t len) {
+    if(cur + len > length)
+        throw std::runtime_error("OOR read/peek");
+    parent->read(dst, len);
+    cur += len;
+}
+
+inline void SliceSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > length)
+        throw std::runtime_error("OOR read/peek");
+    parent->readAt(base + offset, dst, len);
+}
+
+inline void SliceSource::peek(char* dst, int64_t len) const {
+    if(cur + len > length)
+        throw std::runtime_error("OOR read/peek");
+    parent->peek(dst, len);
+}
+
+inline void SliceSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    parent->seek(base + offset);
+    cur = offset;
+}
+
+inline int64_t SliceSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t SliceSource::size() const noexcept {
+    return length;
+}
+
+inline ConcatSource::ConcatSource(std::vector<std::unique_ptr<ISource>> parts)
+: parts(std::move(parts)), part(0), cur(0) {
+    starts.reserve(this->parts.size() + 1);
+    starts.push_back(0);
+    for(const auto& source : this->parts) {
+        if(!source)
+            throw std::runtime_error("Invalid source");
+        starts.push_back(starts.back() + source->size());
+    }
+    seek(0);
+}
+
+inline ConcatSource::ConcatSource(const std::vector<std::filesystem::path>& paths)
+: ConcatSource(openParts(paths)) {
+}
+
+inline std::vector<std::unique_ptr<ISource>>
+ConcatSource::openParts(const std::vector<std::filesystem::path>& paths) {
+    std::vector<std::unique_ptr<ISource>> parts;
+    parts.reserve(paths.size());
+    for(const auto& path : paths) {
+#ifdef ZBIO_HAS_POSIX_IO
+        parts.push_back(std::make_unique<BufferedFileSource>(path));
+#else
+        parts.push_back(std::make_unique<FileSource>(path));
+#endif
+    }
+    return parts;
+}
+
+// Index of the part containing 'offset', skipping empty parts
+inline size_t ConcatSource::locate(int64_t offset) const noexcept {
+    if(offset >= starts.back())
+        return parts.size();
+    return std::upper_bound(starts.begin(), starts.end() - 1, offset) - starts.begin() - 1;
+}
+
+inline size_t ConcatSource::partCount() const noexcept {
+    return parts.size();
+}
+
+inline std::unique_ptr<ISource> ConcatSource::clone() const {
+    std::vector<std::unique_ptr<ISource>> clonedParts;
+    clonedParts.reserve(parts.size());
+    for(const auto& source : parts)
+        clonedParts.push_back(source->clone());
+    auto clone = std::make_unique<ConcatSource>(std::move(clonedParts));
+    clone->seek(cur);
+    return clone;
+}
+
+inline const char* ConcatSource::contiguous(int64_t offset, int64_t len) const noexcept {
+    if(offset < 0 || len < 0 || offset + len > starts.back())
+        return nullptr;
+    const auto i = locate(offset);
+    if(i == parts.size() || offset + len > starts[i + 1])
+        return nullptr;
+    return parts[i]->contiguous(offset - starts[i], len);
+}
+
+inline int64_t ConcatSource::lendWindow(const char*& ptr) noexcept {
+    if(part == parts.size())
+        return 0;
+    // Parts which can't lend windows may be followed by ones which can
+    const auto len = parts[part]->lendWindow(ptr);
+    return std::max<int64_t>(std::min(len, starts[part + 1] - cur), 0);
+}
+
+inline void ConcatSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    if(offset < 0 || offset >= starts.back())
+        return;
+    const auto end = len ? std::min(offset + len, starts.back()) : starts.back();
+    for(auto i = locate(offset); offset < end; ++i) {
+        const auto n = std::min(end, starts[i + 1]) - offset;
+        if(n)
+            parts[i]->advise(offset - starts[i], n, hint);
+        offset += n;
+    }
+}
+
+inline void ConcatSource::read(char* dst, int64_t len) {
+    if(cur + len > starts.back())
+        throw std::runtime_error("OOR read/peek");
+
+    while(len) {
+        const auto n = std::min(len, starts[part + 1] - cur);
+        parts[part]->read(dst, n);
+        dst += n;
+        len -= n;
+        cur += n;
+        if(cur == starts[part + 1])
+            seek(cur); // Move on to the next non-empty part
+    }
+}
+
+inline void ConcatSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > starts.back())
+        throw std::runtime_error("OOR read/peek");
+
+    for(auto i = locate(offset); len; ++i) {
+        const auto n = std::min(len, starts[i + 1] - offset);
+        parts[i]->readAt(offset - starts[i], dst, n);
+        dst += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+inline void ConcatSource::peek(char* dst, int64_t len) const {
+    if(cur + len > starts.back())
+        throw std::runtime_error("OOR read/peek");
+    if(!len)
+        return;
+
+    auto n = std::min(len, starts[part + 1] - cur);
+    parts[part]->peek(dst, n);
+    // Following parts are only positioned once they become current, rewinding them is harmless
+    for(auto i = part + 1; n < len; ++i) {
+        const auto partLen = std::min(len - n, starts[i + 1] - starts[i]);
+        parts[i]->seek(0);
+        parts[i]->peek(dst + n, partLen);
+        n += partLen;
+    }
+}
+
+// The head of the current part is kept at the matching local offset
+inline void ConcatSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+    part = locate(offset);
+    if(part != parts.size())
+        parts[part]->seek(offset - starts[part]);
+}
+
+inline int64_t ConcatSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t ConcatSource::size() const noexcept {
+    return starts.back();
+}
+
+#ifdef ZBIO_HAS_POSIX_IO
+
+namespace detail {
+
+inline FileDescriptor::FileDescriptor(const std::filesystem::path& path, int flags) : fd(-1) {
+    if(!std::filesystem::exists(path) || !std::filesystem::is_regular_file(path))
+        throw std::runtime_error("Invalid path: " + path.generic_string());
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | flags);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "open failed");
+}
+
+inline FileDescriptor::FileDescriptor(FileDescriptor&& other) noexcept : fd(other.fd) {
+    other.fd = -1;
+}
+
+inline FileDescriptor::~FileDescriptor() {
+    if(fd >= 0)
+        ::close(fd);
+}
+
+inline int FileDescriptor::get() const noexcept {
+    return fd;
+}
+
+inline int64_t FileDescriptor::size() const {
+    struct stat st {};
+    if(::fstat(fd, &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "fstat failed");
+    return static_cast<int64_t>(st.st_size);
+}
+
+inline int64_t FileDescriptor::pread(char* dst, int64_t len, int64_t offset) const {
+    int64_t total = 0;
+    while(total < len) {
+        const auto n = ::pread(fd, dst + total, static_cast<size_t>(len - total), offset + total);
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "pread failed");
+        }
+        if(n == 0)
+            break; // EOF
+        total += n;
+    }
+    return total;
+}
+
+inline void FileDescriptor::advise(int64_t offset, int64_t len, AccessHint hint) const noexcept {
+#ifdef POSIX_FADV_NORMAL
+    int advice = POSIX_FADV_NORMAL;
+    switch(hint) {
+    case AccessHint::Normal:
+        advice = POSIX_FADV_NORMAL;
+        break;
+    case AccessHint::Sequential:
+        advice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case AccessHint::Random:
+        advice = POSIX_FADV_RANDOM;
+        break;
+    case AccessHint::WillNeed:
+        advice = POSIX_FADV_WILLNEED;
+        break;
+    case AccessHint::DontNeed:
+        advice = POSIX_FADV_DONTNEED;
+        break;
+    }
+    ::posix_fadvise(fd, offset, len, advice);
+#else
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(len);
+    ZBIO_UNUSED(hint);
+#endif
+}
+
+inline FileMapping::FileMapping(const std::filesystem::path& path) : base(nullptr), length(0) {
+    // The mapping keeps the file referenced, the descriptor can be closed right away.
+    const FileDescriptor file(path);
+    length = file.size();
+
+    // mmap rejects zero length mappings, empty files are represented by a null mapping instead.
+    if(length) {
+        const auto len = static_cast<size_t>(length);
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, file.get(), 0);
+        if(p == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap failed");
+        base = static_cast<char*>(p);
+    }
+}
+
+inline FileMapping::FileMapping(FileMapping&& other) noexcept
+: base(other.base), length(other.length) {
+    other.base = nullptr;
+    other.length = 0;
+}
+
+inline FileMapping::~FileMapping() {
+    if(base)
+        ::munmap(base, static_cast<size_t>(length));
+}
+
+inline const char* FileMapping::data() const noexcept {
+    return base;
+}
+
+inline int64_t FileMapping::size() const noexcept {
+    return length;
+}
+
+#ifdef ZBIO_HAS_IO_URING
+
+inline IoUring::IoUring(unsigned entries)
+: ringFd(-1), sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED), cqRingSize(0),
+  sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqesSize(0), sqTail(nullptr), sqMask(nullptr),
+  sqArray(nullptr), cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr) {
+    io_uring_params params{};
+    ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if(ringFd < 0)
+        return;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                    IORING_OFF_SQ_RING);
+    if(sqRing == MAP_FAILED) {
+        release();
+        return;
+    }
+
+    if(singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd, IORING_OFF_CQ_RING);
+        if(cqRing == MAP_FAILED) {
+            release();
+            return;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if(sqes == MAP_FAILED) {
+        release();
+        return;
+    }
+
+    auto sq = static_cast<char*>(sqRing);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    auto cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+inline IoUring::~IoUring() {
+    release();
+}
+
+inline void IoUring::release() noexcept {
+    if(sqes != MAP_FAILED)
+        ::munmap(sqes, sqesSize);
+    if(cqRing != MAP_FAILED && cqRing != sqRing)
+        ::munmap(cqRing, cqRingSize);
+    if(sqRing != MAP_FAILED)
+        ::munmap(sqRing, sqRingSize);
+    if(ringFd >= 0)
+        ::close(ringFd);
+
+    sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    sqRing = cqRing = MAP_FAILED;
+    ringFd = -1;
+}
+
+inline bool IoUring::valid() const noexcept {
+    return ringFd >= 0;
+}
+
+inline void IoUring::submitRead(int fd, const iovec* iov, int64_t offset, uint64_t userData) {
+    // Single producer, the tail is only ever written by us.
+    const unsigned tail = *sqTail;
+    const unsigned index = tail & *sqMask;
+
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = 1;
+    sqe->off = static_cast<uint64_t>(offset);
+    sqe->user_data = userData;
+
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while(enter(ringFd, 1, 0, 0) < 0) {
+        if(errno != EINTR) {
+            // Nothing was consumed, without SQPOLL the kernel only reads the queue on enter
+            const auto error = errno;
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            throw std::system_error(error, std::generic_category(), "io_uring_enter failed");
+        }
+    }
+}
+
+inline long IoUring::enterSyscall(int ringFd, unsigned toSubmit, unsigned minComplete,
+                                  unsigned flags) noexcept {
+    return ::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+inline std::pair<uint64_t, int32_t> IoUring::waitCompletion() {
+    const unsigned head = *cqHead;
+    while(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        if(enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+    }
+
+    const io_uring_cqe* cqe = &cqes[head & *cqMask];
+    const std::pair<uint64_t, int32_t> completion(cqe->user_data, cqe->res);
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return completion;
+}
+
+#endif // ZBIO_HAS_IO_URING
+
+} // namespace detail
+
+inline MmapSource::MmapSource(const std::string& path) : MmapSource(std::filesystem::path(path)) {
+}
+
+inline MmapSource::MmapSource(const char* path) : MmapSource(std::filesystem::path(path)) {
+}
+
+inline MmapSource::MmapSource(const std::filesystem::path& path)
+: MmapSource(std::make_shared<const detail::FileMapping>(path)) {
+}
+
+// The buffer owner aliases the mapping, so it stays mapped as long as any buffer refers to it
+inline MmapSource::MmapSource(const std::shared_ptr<const detail::FileMapping>& mapping)
+: MmapSource(std::shared_ptr<const char[]>(mapping, mapping->data()),
+             mapping->data(),
+             mapping->size()) {
+}
+
+inline MmapSource::MmapSource(std::shared_ptr<const char[]> owner,
+                              const char* data,
+                              int64_t data_size)
+: BufferSource(std::move(owner), data, data_size) {
+}
+
+inline std::unique_ptr<ISource> MmapSource::clone() const {
+    return std::unique_ptr<ISource>(new MmapSource(*this));
+}
+
+inline void MmapSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    if(offset < 0 || offset >= size())
+        return;
+    len = len ? std::min(len, size() - offset) : size() - offset;
+
+    int advice = MADV_NORMAL;
+    switch(hint) {
+    case AccessHint::Normal:
+        advice = MADV_NORMAL;
+        break;
+    case AccessHint::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case AccessHint::Random:
+        advice = MADV_RANDOM;
+        break;
+    case AccessHint::WillNeed:
+        advice = MADV_WILLNEED;
+        break;
+    case AccessHint::DontNeed:
+        advice = MADV_DONTNEED;
+        break;
+    }
+
+    // madvise wants page aligned addresses
+    static const auto pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<uintptr_t>(contiguous(offset, len));
+    const auto alignedBegin = begin & ~(pageSize - 1);
+    ::madvise(reinterpret_cast<void*>(alignedBegin), begin + len - alignedBegin, advice);
+}
+
+inline std::unique_ptr<ISource> MmapSource::slice(int64_t offset, int64_t length) const {
+    if(offset < 0 || length < 0 || offset + length > size())
+        throw std::runtime_error("OOR slice");
+    return std::unique_ptr<ISource>(new MmapSource(owner(), contiguous(offset, length), length));
+}
+
+inline BufferedFileSource::BufferedFileSource(const std::string& path, int64_t windowSize)
+: BufferedFileSource(std::filesystem::path(path), windowSize) {
+}
+
+inline BufferedFileSource::BufferedFileSource(const char* path, int64_t windowSize)
+: BufferedFileSource(std::filesystem::path(path), windowSize) {
+}
+
+inline BufferedFileSource::BufferedFileSource(const std::filesystem::path& path, int64_t windowSize)
+: BufferedFileSource(std::make_shared<const detail::FileDescriptor>(path), windowSize) {
+}
+
+inline BufferedFileSource::BufferedFileSource(std::shared_ptr<const detail::FileDescriptor> file,
+                                              int64_t windowSize)
+: file(std::move(file)), size_(0), window(nullptr), windowCapacity(0), windowSize(windowSize),
+  minWindowSize(std::min(windowSize, minAdaptiveWindowSize)),
+  maxWindowSize(std::max(windowSize, maxAdaptiveWindowSize)), windowOffset(0), windowLength(0),
+  cur(0), sequentialEnd(0), stats_{ AccessHint::Sequential, windowSize, 0, 0 } {
+    if(windowSize <= 0)
+        throw std::runtime_error("Invalid read-ahead window size");
+    size_ = this->file->size();
+    window = std::make_unique<char[]>(windowSize);
+    windowCapacity = windowSize;
+}
+
+inline BufferedFileSource::Stats BufferedFileSource::stats() const noexcept {
+    auto stats = stats_;
+    stats.windowSize = windowSize;
+    return stats;
+}
+
+inline std::unique_ptr<ISource> BufferedFileSource::clone() const {
+    auto clone = std::unique_ptr<BufferedFileSource>(new BufferedFileSource(file, windowSize));
+    clone->minWindowSize = minWindowSize;
+    clone->maxWindowSize = maxWindowSize;
+    clone->cur = cur;
+    return clone;
+}
+
+inline int64_t BufferedFileSource::lendWindow(const char*& ptr) noexcept {
+    if(!inWindow(cur, 1))
+        return 0;
+    ptr = &window[cur - windowOffset];
+    return windowOffset + windowLength - cur;
+}
+
+// Pattern hints preset the read-ahead instead of waiting for it to adapt
+inline void BufferedFileSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    if(hint == AccessHint::Sequential)
+        windowSize = maxWindowSize;
+    else if(hint == AccessHint::Random)
+        windowSize = minWindowSize;
+    file->advise(offset, len, hint);
+}
+
+inline bool BufferedFileSource::inWindow(int64_t offset, int64_t len) const noexcept {
+    return offset >= windowOffset && offset + len <= windowOffset + windowLength;
+}
+
+inline void BufferedFileSource::adapt(int64_t offset) noexcept {
+    ++stats_.fills;
+    if(offset == sequentialEnd) {
+        ++stats_.sequentialFills;
+        stats_.pattern = AccessHint::Sequential;
+        windowSize = std::min(windowSize * 2, maxWindowSize);
+    } else {
+        stats_.pattern = AccessHint::Random;
+        windowSize = std::max(windowSize / 4, minWindowSize);
+    }
+}
+
+inline void BufferedFileSource::fill(int64_t offset) {
+    windowLength = 0; // Keep the window consistent if pread throws
+    windowOffset = offset;
+    if(windowCapacity < windowSize) {
+        window.reset();
+        window = std::make_unique<char[]>(windowSize);
+        windowCapacity = windowSize;
+    }
+    windowLength = file->pread(window.get(), std::min(windowSize, size_ - offset), offset);
+    sequentialEnd = offset + windowLength;
+}
+
+inline void BufferedFileSource::read(char* dst, int64_t len) {
+    if(inWindow(cur, len)) {
+        memcpy(dst, &window[cur - windowOffset], len);
+        cur += len;
+        return;
+    }
+
+    if(cur + len > size_)
+        throw std::runtime_error("OOR read/peek");
+    if(!len)
+        return;
+
+    // Drain whatever part of the request is still in the window
+    if(inWindow(cur, 1)) {
+        const auto available = windowOffset + windowLength - cur;
+        memcpy(dst, &window[cur - windowOffset], available);
+        dst += available;
+        len -= available;
+        cur += available;
+    }
+
+    adapt(cur);
+    if(len >= windowSize) {
+        if(file->pread(dst, len, cur) != len)
+            throw std::runtime_error("OOR read/peek");
+        sequentialEnd = cur + len;
+    } else {
+        fill(cur);
+        if(windowLength < len)
+            throw std::runtime_error("OOR read/peek");
+        memcpy(dst, window.get(), len);
+    }
+    cur += len;
+}
+
+// Served from the window if possible, without refilling it or affecting the pattern detection
+inline void BufferedFileSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > size_)
+        throw std::runtime_error("OOR read/peek");
+    if(inWindow(offset, len)) {
+        memcpy(dst, &window[offset - windowOffset], len);
+        return;
+    }
+    if(file->pread(dst, len, offset) != len)
+        throw std::runtime_error("OOR read/peek");
+}
+
+inline void BufferedFileSource::peek(char* dst, int64_t len) const {
+    if(inWindow(cur, len)) {
+        memcpy(dst, &window[cur - windowOffset], len);
+        return;
+    }
+
+    if(cur + len > size_ || file->pread(dst, len, cur) != len)
+        throw std::runtime_error("OOR read/peek");
+}
+
+inline void BufferedFileSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset; // The window is kept, seeks back into it are served without I/O
+}
+
+inline int64_t BufferedFileSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t BufferedFileSource::size() const noexcept {
+    return size_;
+}
+
+inline PreadSource::PreadSource(const std::string& path)
+: PreadSource(std::filesystem::path(path)) {
+}
+
+inline PreadSource::PreadSource(const char* path) : PreadSource(std::filesystem::path(path)) {
+}
+
+inline PreadSource::PreadSource(const std::filesystem::path& path)
+: file(std::make_shared<const detail::FileDescriptor>(path)), base(0), size_(0), cur(0) {
+    size_ = file->size();
+}
+
+inline std::unique_ptr<ISource> PreadSource::clone() const {
+    return std::make_unique<PreadSource>(*this);
+}
+
+inline std::unique_ptr<ISource> PreadSource::slice(int64_t offset, int64_t length) const {
+    if(offset < 0 || length < 0 || offset + length > size_)
+        throw std::runtime_error("OOR slice");
+
+    auto slice = std::make_unique<PreadSource>(*this);
+    slice->base = base + offset;
+    slice->size_ = length;
+    slice->cur = 0;
+    return slice;
+}
+
+inline void PreadSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    if(offset < 0 || offset >= size_)
+        return;
+    len = len ? std::min(len, size_ - offset) : size_ - offset;
+    file->advise(base + offset, len, hint);
+}
+
+inline void PreadSource::read(char* dst, int64_t len) {
+    PreadSource::peek(dst, len);
+    cur += len;
+}
+
+inline void PreadSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > size_ || file->pread(dst, len, base + offset) != len)
+        throw std::runtime_error("OOR read/peek");
+}
+
+inline void PreadSource::peek(char* dst, int64_t len) const {
+    if(cur + len > size_ || file->pread(dst, len, base + cur) != len)
+        throw std::runtime_error("OOR read/peek");
+}
+
+inline void PreadSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+}
+
+inline int64_t PreadSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t PreadSource::size() const noexcept {
+    return size_;
+}
+
+inline void DirectFileSource::AlignedFree::operator()(char* p) const noexcept {
+    ::free(p);
+}
+
+inline DirectFileSource::DirectFileSource(const std::string& path, int64_t blockSize)
+: DirectFileSource(std::filesystem::path(path), blockSize) {
+}
+
+inline DirectFileSource::DirectFileSource(const char* path, int64_t blockSize)
+: DirectFileSource(std::filesystem::path(path), blockSize) {
+}
+
+inline DirectFileSource::DirectFileSource(const std::filesystem::path& path, int64_t blockSize)
+: DirectFileSource(nullptr, false, blockSize) {
+#if defined(O_DIRECT)
+    try {
+        file = std::make_shared<const detail::FileDescriptor>(path, O_DIRECT);
+        direct = true;
+    } catch(const std::system_error& e) {
+        if(e.code() != std::errc::invalid_argument)
+            throw;
+    }
+#endif
+    if(!file)
+        file = std::make_shared<const detail::FileDescriptor>(path);
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    direct = ::fcntl(file->get(), F_NOCACHE, 1) == 0;
+#endif
+    size_ = file->size();
+}
+
+inline DirectFileSource::DirectFileSource(std::shared_ptr<const detail::FileDescriptor> file,
+                                          bool direct,
+                                          int64_t blockSize)
+: file(std::move(file)), direct(direct), size_(0), block(nullptr), blockSize(0), blockOffset(0),
+  blockLength(0), cur(0) {
+    if(blockSize <= 0)
+        throw std::runtime_error("Invalid block size");
+    this->blockSize = (blockSize + alignment - 1) / alignment * alignment;
+
+    void* p = nullptr;
+    if(::posix_memalign(&p, alignment, static_cast<size_t>(this->blockSize)) != 0)
+        throw std::bad_alloc();
+    block.reset(static_cast<char*>(p));
+
+    if(this->file)
+        size_ = this->file->size();
+}
+
+inline bool DirectFileSource::isDirect() const noexcept {
+    return direct;
+}
+
+inline std::unique_ptr<ISource> DirectFileSource::clone() const {
+    auto clone = std::unique_ptr<DirectFileSource>(new DirectFileSource(file, direct, blockSize));
+    clone->cur = cur;
+    return clone;
+}
+
+inline int64_t DirectFileSource::lendWindow(const char*& ptr) noexcept {
+    if(cur < blockOffset || cur >= blockOffset + blockLength)
+        return 0;
+    ptr = block.get() + (cur - blockOffset);
+    return blockOffset + blockLength - cur;
+}
+
+// Load the aligned block containing 'offset'
+inline void DirectFileSource::fill(int64_t offset) const {
+    blockLength = 0; // Keep the block consistent if reading throws
+    blockOffset = offset / alignment * alignment;
+
+    // Direct reads have to stay aligned, stop at the first short read which marks the end of file
+    const auto wanted = std::min(blockSize, size_ - blockOffset);
+    int64_t total = 0;
+    while(total < wanted) {
+        const auto n = ::pread(file->get(), block.get() + total,
+                               static_cast<size_t>(blockSize - total), blockOffset + total);
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "pread failed");
+        }
+        total += n;
+        if(n == 0 || total % alignment)
+            break;
+    }
+    blockLength = std::min(total, wanted);
+
+    if(!direct)
+        file->advise(blockOffset, blockLength, AccessHint::DontNeed);
+}
+
+inline void DirectFileSource::copy(char* dst, int64_t offset, int64_t len) const {
+    if(offset + len > size_)
+        throw std::runtime_error("OOR read/peek");
+
+    while(len) {
+        if(offset < blockOffset || offset >= blockOffset + blockLength)
+            fill(offset);
+        if(offset >= blockOffset + blockLength)
+            throw std::runtime_error("OOR read/peek"); // File shrunk
+        const auto n = std::min(len, blockOffset + blockLength - offset);
+        memcpy(dst, block.get() + (offset - blockOffset), n);
+        dst += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+inline void DirectFileSource::read(char* dst, int64_t len) {
+    copy(dst, cur, len);
+    cur += len;
+}
+
+inline void DirectFileSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0)
+        throw std::runtime_error("OOR read/peek");
+    copy(dst, offset, len);
+}
+
+inline void DirectFileSource::peek(char* dst, int64_t len) const {
+    copy(dst, cur, len);
+}
+
+inline void DirectFileSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+}
+
+inline int64_t DirectFileSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t DirectFileSource::size() const noexcept {
+    return size_;
+}
+
+inline StreamSource::StreamSource(int fd, int64_t lookback, int64_t chunkSize)
+: fd(fd), lookback(lookback), chunkSize(chunkSize), cur(0), bufferOffset(0), bufferLength(0),
+  eof(false) {
+    if(fd < 0)
+        throw std::runtime_error("Invalid file descriptor");
+    if(lookback < 0 || chunkSize <= 0)
+        throw std::runtime_error("Invalid window size");
+    buffer.resize(static_cast<size_t>(lookback + chunkSize));
+}
+
+// Buffer the stream up to 'end', or as far as it goes. Data before the lookback range of the read
+// head is dropped first, which also skips over data after forward seeks.
+inline void StreamSource::fill(int64_t end) const {
+    while(bufferOffset + bufferLength < end && !eof) {
+        const auto keep =
+        std::max(bufferOffset, std::min(cur - lookback, bufferOffset + bufferLength));
+        bufferLength -= keep - bufferOffset;
+        memmove(buffer.data(), buffer.data() + (keep - bufferOffset), bufferLength);
+        bufferOffset = keep;
+
+        if(static_cast<int64_t>(buffer.size()) < bufferLength + chunkSize)
+            buffer.resize(static_cast<size_t>(bufferLength + chunkSize));
+
+        const auto n = ::read(fd, buffer.data() + bufferLength, static_cast<size_t>(chunkSize));
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "read failed");
+        }
+        eof = n == 0;
+        bufferLength += n;
+    }
+}
+
+inline int64_t StreamSource::lendWindow(const char*& ptr) noexcept {
+    if(cur < bufferOffset || cur >= bufferOffset + bufferLength)
+        return 0;
+    ptr = buffer.data() + (cur - bufferOffset);
+    return bufferOffset + bufferLength - cur;
+}
+
+inline void StreamSource::read(char* dst, int64_t len) {
+    peek(dst, len);
+    cur += len;
+}
+
+inline void StreamSource::peek(char* dst, int64_t len) const {
+    fill(cur + len);
+    if(cur + len > bufferOffset + bufferLength)
+        throw std::runtime_error("OOR read/peek");
+    memcpy(dst, buffer.data() + (cur - bufferOffset), len);
+}
+
+// Forward seeks are lazy, the skipped data is consumed by the next read
+inline void StreamSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    if(offset < bufferOffset)
+        throw std::runtime_error("Seek before lookback window");
+    cur = offset;
+}
+
+inline int64_t StreamSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t StreamSource::size() const noexcept {
+    return -1;
+}
+
+#ifdef ZBIO_HAS_IO_URING
+
+inline UringFileSource::UringFileSource(const std::string& path,
+                                        int64_t blockSize,
+                                        unsigned queueDepth)
+: UringFileSource(std::filesystem::path(path), blockSize, queueDepth) {
+}
+
+inline UringFileSource::UringFileSource(const char* path, int64_t blockSize, unsigned queueDepth)
+: UringFileSource(std::filesystem::path(path), blockSize, queueDepth) {
+}
+
+inline UringFileSource::UringFileSource(const std::filesystem::path& path,
+                                        int64_t blockSize,
+                                        unsigned queueDepth)
+: UringFileSource(std::make_shared<const detail::FileDescriptor>(path), blockSize, queueDepth) {
+}
+
+inline UringFileSource::UringFileSource(std::shared_ptr<const detail::FileDescriptor> file,
+                                        int64_t blockSize,
+                                        unsigned queueDepth)
+: file(std::move(file)), size_(0), blockSize(blockSize), cur(0), buffers(nullptr),
+  blocks(queueDepth), ring(nullptr), inFlight(0) {
+    if(blockSize <= 0 || queueDepth == 0)
+        throw std::runtime_error("Invalid block size or queue depth");
+    size_ = this->file->size();
+
+    buffers = std::make_unique<char[]>(blockSize * queueDepth);
+    for(unsigned i = 0; i < queueDepth; ++i) {
+        blocks[i].index = -1;
+        blocks[i].length = 0;
+        blocks[i].state = BlockState::Empty;
+        blocks[i].iov.iov_base = &buffers[i * blockSize];
+        blocks[i].iov.iov_len = static_cast<size_t>(blockSize);
+    }
+
+    ring = std::make_unique<detail::IoUring>(queueDepth);
+    if(!ring->valid())
+        ring.reset();
+}
+
+inline UringFileSource::~UringFileSource() {
+    // The kernel may still write into our buffers, wait for all outstanding reads.
+    try {
+        while(inFlight)
+            reap();
+    } catch(...) {
+    }
+}
+
+inline bool UringFileSource::usesIoUring() const noexcept {
+    return ring != nullptr;
+}
+
+inline std::unique_ptr<ISource> UringFileSource::clone() const {
+    auto clone = std::unique_ptr<UringFileSource>(
+    new UringFileSource(file, blockSize, static_cast<unsigned>(blocks.size())));
+    clone->cur = cur;
+    return clone;
+}
+
+inline int64_t UringFileSource::lendWindow(const char*& ptr) noexcept {
+    const auto index = cur / blockSize;
+    const auto offset = cur - index * blockSize;
+    const auto block = findBlock(index);
+    if(!block || block->state != BlockState::Ready || block->length <= offset)
+        return 0;
+    ptr = static_cast<const char*>(block->iov.iov_base) + offset;
+    return block->length - offset;
+}
+
+inline void UringFileSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    file->advise(offset, len, hint);
+}
+
+inline int64_t UringFileSource::blockLength(int64_t index) const noexcept {
+    return std::min(blockSize, size_ - index * blockSize);
+}
+
+inline const UringFileSource::Block* UringFileSource::findBlock(int64_t index) const noexcept {
+    for(const auto& block : blocks) {
+        if(block.index == index && block.state != BlockState::Empty)
+            return &block;
+    }
+    return nullptr;
+}
+
+inline void UringFileSource::reap() {
+    const auto [slot, res] = ring->waitCompletion();
+    auto& block = blocks[slot];
+    --inFlight;
+    // Failed reads leave the block empty, acquire() retries them synchronously to surface errors.
+    block.length = res < 0 ? 0 : res;
+    block.state = res < 0 ? BlockState::Empty : BlockState::Ready;
+}
+
+// Start reading block 'index' into a slot not holding a block of the current read-ahead range
+inline void UringFileSource::schedule(int64_t index) {
+    const int64_t first = cur / blockSize;
+    const int64_t last = first + static_cast<int64_t>(blocks.size());
+
+    auto victim = std::find_if(blocks.begin(), blocks.end(), [&](const Block& b) {
+        return b.state == BlockState::Empty || b.index < first || b.index >= last;
+    });
+    if(victim == blocks.end())
+        return;
+    while(victim->state == BlockState::InFlight)
+        reap();
+
+    // The slot only counts as in flight once the kernel has the request, a failed submit leaves
+    // it empty instead of waiting for a completion which never arrives
+    victim->index = index;
+    victim->length = 0;
+    victim->state = BlockState::Empty;
+    victim->iov.iov_len = static_cast<size_t>(blockLength(index));
+    ring->submitRead(file->get(), &victim->iov, index * blockSize, victim - blocks.begin());
+    victim->state = BlockState::InFlight;
+    ++inFlight;
+}
+
+inline const UringFileSource::Block& UringFileSource::acquire(int64_t index) {
+    const int64_t blockCount = (size_ + blockSize - 1) / blockSize;
+
+    auto block = const_cast<Block*>(findBlock(index));
+    if(ring) {
+        if(!block) {
+            schedule(index);
+            block = const_cast<Block*>(findBlock(index));
+        }
+        // Keep the queue full with the blocks following the requested one
+        for(int64_t next = index + 1; next < std::min(blockCount, index + (int64_t)blocks.size());
+            ++next) {
+            if(!findBlock(next))
+                schedule(next);
+        }
+        while(block && block->state == BlockState::InFlight)
+            reap();
+        if(block && block->state != BlockState::Ready)
+            block = nullptr;
+    }
+
+    // Synchronous path, used without io_uring and to recover from failed reads
+    if(!block) {
+        block = &blocks[index % blocks.size()];
+        while(block->state == BlockState::InFlight)
+            reap();
+        block->index = index;
+        block->length = 0;
+        block->state = BlockState::Empty;
+    }
+
+    // Complete short reads synchronously
+    const auto expected = blockLength(index);
+    if(block->length < expected) {
+        auto dst = static_cast<char*>(block->iov.iov_base);
+        block->length += file->pread(dst + block->length, expected - block->length,
+                                     index * blockSize + block->length);
+        if(block->length != expected)
+            throw std::runtime_error("OOR read/peek");
+        block->state = BlockState::Ready;
+    }
+    return *block;
+}
+
+inline void UringFileSource::read(char* dst, int64_t len) {
+    if(cur + len > size_)
+        throw std::runtime_error("OOR read/peek");
+
+    while(len) {
+        const auto& block = acquire(cur / blockSize);
+        const auto offset = cur - block.index * blockSize;
+        const auto n = std::min(len, block.length - offset);
+        memcpy(dst, static_cast<const char*>(block.iov.iov_base) + offset, n);
+        dst += n;
+        len -= n;
+        cur += n;
+    }
+}
+
+// Peeks are served from landed blocks where possible and don't start any new I/O otherwise.
+// Positional reads bypass the block queue, they would evict read-ahead blocks
+inline void UringFileSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0 || offset + len > size_ || file->pread(dst, len, offset) != len)
+        throw std::runtime_error("OOR read/peek");
+}
+
+inline void UringFileSource::peek(char* dst, int64_t len) const {
+    if(cur + len > size_)
+        throw std::runtime_error("OOR read/peek");
+
+    auto pos = cur;
+    while(len) {
+        const auto index = pos / blockSize;
+        const auto offset = pos - index * blockSize;
+        const auto n = std::min(len, blockLength(index) - offset);
+        const auto block = findBlock(index);
+        if(block && block->state == BlockState::Ready && block->length >= offset + n)
+            memcpy(dst, static_cast<const char*>(block->iov.iov_base) + offset, n);
+        else if(file->pread(dst, n, pos) != n)
+            throw std::runtime_error("OOR read/peek");
+        dst += n;
+        len -= n;
+        pos += n;
+    }
+}
+
+inline void UringFileSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+}
+
+inline int64_t UringFileSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t UringFileSource::size() const noexcept {
+    return size_;
+}
+
+#endif // ZBIO_HAS_IO_URING
+
+#endif // ZBIO_HAS_POSIX_IO
+
+inline bool BlockCache::FileId::operator==(const FileId& other) const noexcept {
+    return device == other.device && inode == other.inode && size == other.size &&
+           modified == other.modified;
+}
+
+inline bool BlockCache::Key::operator==(const Key& other) const noexcept {
+    return file == other.file && index == other.index;
+}
+
+inline size_t BlockCache::KeyHash::operator()(const Key& key) const noexcept {
+    size_t hash = std::hash<uint64_t>{}(key.file.device);
+    hash = hash * 31 + std::hash<uint64_t>{}(key.file.inode);
+    hash = hash * 31 + std::hash<int64_t>{}(key.file.modified);
+    return hash * 31 + std::hash<int64_t>{}(key.index);
+}
+
+inline BlockCache::BlockCache(int64_t capacity, int64_t blockSize)
+: capacity_(capacity), blockSize_(blockSize) {
+    if(capacity < 0 || blockSize <= 0)
+        throw std::runtime_error("Invalid cache size");
+}
+
+inline std::shared_ptr<BlockCache> BlockCache::global() {
+    static const auto cache = std::make_shared<BlockCache>();
+    return cache;
+}
+
+inline BlockCache::FileId BlockCache::identify(const std::filesystem::path& path) {
+#ifdef ZBIO_HAS_POSIX_IO
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0)
+        throw std::runtime_error("Invalid path: " + path.string());
+#ifdef __APPLE__
+    const auto& mtime = st.st_mtimespec;
+#else
+    const auto& mtime = st.st_mtim;
+#endif
+    return { static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino),
+             static_cast<int64_t>(st.st_size),
+             static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec };
+#else
+    const auto canonical = std::filesystem::canonical(path);
+    const auto modified = std::filesystem::last_write_time(canonical).time_since_epoch();
+    return { 0, std::hash<std::filesystem::path::string_type>{}(canonical.native()),
+             static_cast<int64_t>(std::filesystem::file_size(canonical)),
+             std::chrono::duration_cast<std::chrono::nanoseconds>(modified).count() };
+#endif
+}
+
+inline int64_t BlockCache::blockSize() const noexcept {
+    return blockSize_;
+}
+
+inline int64_t BlockCache::capacity() const noexcept {
+    return capacity_;
+}
+
+template <typename Load>
+inline BlockCache::Block BlockCache::get(const FileId& file, int64_t index, Load&& load) {
+    const Key key{ file, index };
+    {
+        std::lock_guard lock(mutex);
+        if(const auto it = entries.find(key); it != entries.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            ++hits;
+            return it->second->second;
+        }
+        ++misses;
+    }
+
+    Block block = load();
+
+    std::lock_guard lock(mutex);
+    // Another thread may have loaded the block in the meantime
+    if(const auto it = entries.find(key); it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+    lru.emplace_front(key, block);
+    entries.emplace(key, lru.begin());
+    bytes += static_cast<int64_t>(block->size());
+    evict();
+    return block;
+}
+
+inline void BlockCache::evict() {
+    while(bytes > capacity_ && !lru.empty()) {
+        bytes -= static_cast<int64_t>(lru.back().second->size());
+        entries.erase(lru.back().first);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+inline BlockCache::Stats BlockCache::stats() const {
+    std::lock_guard lock(mutex);
+    return { hits, misses, evictions, bytes, static_cast<int64_t>(lru.size()) };
+}
+
+inline void BlockCache::clear() {
+    std::lock_guard lock(mutex);
+    entries.clear();
+    lru.clear();
+    bytes = 0;
+}
+
+inline CachedSource::CachedSource(const std::string& path, std::shared_ptr<BlockCache> cache)
+: CachedSource(std::filesystem::path(path), std::move(cache)) {
+}
+
+inline CachedSource::CachedSource(const char* path, std::shared_ptr<BlockCache> cache)
+: CachedSource(std::filesystem::path(path), std::move(cache)) {
+}
+
+// Blocks are loaded with single positional reads where available, caching on top of another
+// buffering layer would only copy the data twice.
+inline CachedSource::CachedSource(const std::filesystem::path& path,
+                                  std::shared_ptr<BlockCache> cache)
+#ifdef ZBIO_HAS_POSIX_IO
+: CachedSource(std::make_unique<PreadSource>(path), BlockCache::identify(path), std::move(cache)) {
+#else
+: CachedSource(std::make_unique<FileSource>(path), BlockCache::identify(path), std::move(cache)) {
+#endif
+}
+
+inline CachedSource::CachedSource(std::unique_ptr<ISource> source,
+                                  const BlockCache::FileId& file,
+                                  std::shared_ptr<BlockCache> cache)
+: source(std::move(source)), cache(std::move(cache)), file(file), size_(0), cur(0),
+  blockIndex(-1) {
+    if(!this->source || !this->cache)
+        throw std::runtime_error("Invalid source");
+    size_ = this->source->size();
+}
+
+inline const std::shared_ptr<BlockCache>& CachedSource::getCache() const noexcept {
+    return cache;
+}
+
+inline std::unique_ptr<ISource> CachedSource::clone() const {
+    auto clone = std::make_unique<CachedSource>(source->clone(), file, cache);
+    clone->cur = cur;
+    return clone;
+}
+
+inline int64_t CachedSource::lendWindow(const char*& ptr) noexcept {
+    const auto blockSize = cache->blockSize();
+    if(!block || cur / blockSize != blockIndex)
+        return 0;
+    const auto offset = cur - blockIndex * blockSize;
+    if(offset >= static_cast<int64_t>(block->size()))
+        return 0;
+    ptr = block->data() + offset;
+    return static_cast<int64_t>(block->size()) - offset;
+}
+
+inline void CachedSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    source->advise(offset, len, hint);
+}
+
+inline const std::vector<char>& CachedSource::acquire(int64_t index) const {
+    if(block && blockIndex == index)
+        return *block;
+
+    block = cache->get(file, index, [&]() {
+        const auto offset = index * cache->blockSize();
+        auto data = std::make_shared<std::vector<char>>(
+        static_cast<size_t>(std::min(cache->blockSize(), size_ - offset)));
+        source->seek(offset);
+        source->read(data->data(), static_cast<int64_t>(data->size()));
+        return BlockCache::Block(std::move(data));
+    });
+    blockIndex = index;
+    return *block;
+}
+
+inline void CachedSource::copy(char* dst, int64_t offset, int64_t len) const {
+    if(offset + len > size_)
+        throw std::runtime_error("OOR read/peek");
+
+    const auto blockSize = cache->blockSize();
+    while(len) {
+        const auto& data = acquire(offset / blockSize);
+        const auto begin = offset % blockSize;
+        const auto n = std::min(len, static_cast<int64_t>(data.size()) - begin);
+        memcpy(dst, data.data() + begin, n);
+        dst += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+inline void CachedSource::read(char* dst, int64_t len) {
+    copy(dst, cur, len);
+    cur += len;
+}
+
+inline void CachedSource::readAt(int64_t offset, char* dst, int64_t len) {
+    if(offset < 0 || len < 0)
+        throw std::runtime_error("OOR read/peek");
+    copy(dst, offset, len);
+}
+
+inline void CachedSource::peek(char* dst, int64_t len) const {
+    copy(dst, cur, len);
+}
+
+inline void CachedSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+}
+
+inline int64_t CachedSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t CachedSource::size() const noexcept {
+    return size_;
+}
+
+inline ReadAheadSource::ReadAheadSource(const std::string& path, int64_t blockSize)
+: ReadAheadSource(std::filesystem::path(path), blockSize) {
+}
+
+inline ReadAheadSource::ReadAheadSource(const char* path, int64_t blockSize)
+: ReadAheadSource(std::filesystem::path(path), blockSize) {
+}
+
+inline ReadAheadSource::ReadAheadSource(const std::filesystem::path& path, int64_t blockSize)
+#ifdef ZBIO_HAS_POSIX_IO
+: ReadAheadSource(std::make_unique<PreadSource>(path), blockSize) {
+#else
+: ReadAheadSource(std::make_unique<FileSource>(path), blockSize) {
+#endif
+}
+
+inline ReadAheadSource::ReadAheadSource(std::unique_ptr<ISource> source, int64_t blockSize)
+: source(std::move(source)), size_(0), blockSize(blockSize), cur(0) {
+    if(!this->source)
+        throw std::runtime_error("Invalid source");
+    if(blockSize <= 0)
+        throw std::runtime_error("Invalid block size");
+
+    size_ = this->source->size();
+    cur = this->source->tell();
+    requestOffset = cur;
+    for(auto& slot : slots)
+        slot.data = std::make_unique<char[]>(static_cast<size_t>(blockSize));
+    thread = std::thread(&ReadAheadSource::produce, this);
+}
+
+inline ReadAheadSource::~ReadAheadSource() {
+    stopping = true;
+    wake();
+    thread.join();
+}
+
+// Spin briefly before parking, handoffs are usually quick when both threads keep up
+template <typename Ready>
+inline void ReadAheadSource::park(Ready&& ready) const {
+    for(int i = 0; i < spinCount; ++i) {
+        if(ready())
+            return;
+    }
+
+    std::unique_lock lock(parkMutex);
+    ++parked;
+    parkCondition.wait(lock, ready);
+    --parked;
+}
+
+// Parking threads register before their last check, so either they see the state change or the
+// waker sees them and synchronizes on the mutex.
+inline void ReadAheadSource::wake() const {
+    if(!parked)
+        return;
+    {
+        std::lock_guard lock(parkMutex);
+    }
+    parkCondition.notify_all();
+}
+
+// I/O thread
+inline void ReadAheadSource::produce() {
+    uint64_t filled = 0;
+    uint64_t currentGeneration = generation;
+    int64_t next = requestOffset;
+
+    for(;;) {
+        auto& slot = slots[filled % 2];
+        park([&]() { return slot.state == SlotState::Empty || stopping; });
+        if(stopping)
+            return;
+
+        if(const uint64_t requested = generation; requested != currentGeneration) {
+            currentGeneration = requested;
+            next = requestOffset;
+        }
+        // Wait for a restart once the end, or a failing read, is reached
+        if(next >= size_) {
+            park([&]() { return generation != currentGeneration || stopping; });
+            continue;
+        }
+
+        slot.offset = next;
+        slot.length = std::min(blockSize, size_ - next);
+        slot.generation = currentGeneration;
+        slot.error = nullptr;
+        try {
+            std::lock_guard lock(sourceMutex);
+            source->seek(next);
+            source->read(slot.data.get(), slot.length);
+            next += slot.length;
+        } catch(...) {
+            slot.length = 0;
+            slot.error = std::current_exception();
+            next = size_;
+        }
+        slot.state = SlotState::Ready;
+        ++filled;
+        wake();
+    }
+}
+
+inline void ReadAheadSource::release(Slot& slot) const {
+    slot.state = SlotState::Empty;
+    ++consumed;
+    wake();
+}
+
+// Return the block containing 'offset', restarting the read-ahead there if it's out of range.
+// Without 'consume' the current block is kept when 'offset' lies in the following one.
+inline const ReadAheadSource::Slot& ReadAheadSource::acquire(int64_t offset, bool consume) const {
+    for(;;) {
+        auto& slot = slots[consumed % 2];
+        park([&]() { return slot.state == SlotState::Ready; });
+
+        if(slot.generation != generation) {
+            release(slot); // Stale read-ahead from before a restart
+            continue;
+        }
+        const auto end = slot.offset + slot.length;
+        if(slot.error && offset == slot.offset)
+            std::rethrow_exception(slot.error);
+        if(!slot.error && offset >= slot.offset && offset < end)
+            return slot;
+
+        // The I/O thread continues at 'end', wait for the next block instead of restarting
+        if(!slot.error && offset >= end && offset < end + blockSize) {
+            if(!consume) {
+                auto& following = slots[(consumed + 1) % 2];
+                park([&]() { return following.state == SlotState::Ready; });
+                if(following.generation == generation && !following.error &&
+                   offset < following.offset + following.length)
+                    return following;
+            }
+            release(slot);
+            continue;
+        }
+
+        requestOffset = offset;
+        ++generation;
+        release(slot);
+    }
+}
+
+inline void ReadAheadSource::copy(char* dst, int64_t offset, int64_t len, bool consume) const {
+    if(offset + len > size_)
+        throw std::runtime_error("OOR read/peek");
+
+    while(len) {
+        const auto& slot = acquire(offset, consume);
+        const auto n = std::min(len, slot.offset + slot.length - offset);
+        memcpy(dst, slot.data.get() + (offset - slot.offset), n);
+        dst += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+inline std::unique_ptr<ISource> ReadAheadSource::clone() const {
+    std::unique_ptr<ISource> sourceClone;
+    {
+        std::lock_guard lock(sourceMutex);
+        sourceClone = source->clone();
+    }
+    sourceClone->seek(cur);
+    return std::make_unique<ReadAheadSource>(std::move(sourceClone), blockSize);
+}
+
+inline int64_t ReadAheadSource::lendWindow(const char*& ptr) noexcept {
+    const auto& slot = slots[consumed % 2];
+    if(slot.state != SlotState::Ready || slot.generation != generation || cur < slot.offset ||
+       cur >= slot.offset + slot.length)
+        return 0;
+    ptr = slot.data.get() + (cur - slot.offset);
+    return slot.offset + slot.length - cur;
+}
+
+inline void ReadAheadSource::advise(int64_t offset, int64_t len, AccessHint hint) noexcept {
+    std::lock_guard lock(sourceMutex);
+    source->advise(offset, len, hint);
+}
+
+inline void ReadAheadSource::read(char* dst, int64_t len) {
+    copy(dst, cur, len, true);
+    cur += len;
+}
+
+// Positional reads don't disturb the read-ahead, they go to the wrapped source directly
+inline void ReadAheadSource::readAt(int64_t offset, char* dst, int64_t len) {
+    std::lock_guard lock(sourceMutex);
+    source->readAt(offset, dst, len);
+}
+
+inline void ReadAheadSource::peek(char* dst, int64_t len) const {
+    copy(dst, cur, len, false);
+}
+
+// Seeks are lazy, the read-ahead is only restarted if the next read falls outside of it
+inline void ReadAheadSource::seek(int64_t offset) {
+    if(offset < 0)
+        throw std::runtime_error("negative OOR seek");
+    cur = offset;
+}
+
+inline int64_t ReadAheadSource::tell() const noexcept {
+    return cur;
+}
+
+inline int64_t ReadAheadSource::size() const noexcept {
+    return size_;
+}
+
+template <typename T>
+inline View<T>::View(const T* data, size_t count) noexcept
+: owned(nullptr), ptr(data), count(count) {
+}
+
+template <typename T>
+inline View<T>::View(std::unique_ptr<T[]> data, size_t count) noexcept
+: owned(std::move(data)), ptr(owned.get()), count(count) {
+}
+
+template <typename T>
+inline const T* View<T>::data() const noexcept {
+    return ptr;
+}
+
+template <typename T>
+inline size_t View<T>::size() const noexcept {
+    return count;
+}
+
+template <typename T>
+inline bool View<T>::empty() const noexcept {
+    return count == 0;
+}
+
+template <typename T>
+inline bool View<T>::isBorrowed() const noexcept {
+    return !owned;
+}
+
+template <typename T>
+inline const T* View<T>::begin() const noexcept {
+    return ptr;
+}
+
+template <typename T>
+inline const T* View<T>::end() const noexcept {
+    return ptr + count;
+}
+
+template <typename T>
+inline const T& View<T>::operator[](size_t i) const noexcept {
+    return ptr[i];
+}
+
+inline StringPool::StringPool(bool deduplicate, size_t chunkSize)
+: chunkSize(std::max<size_t>(chunkSize, 1)), deduplicate(deduplicate) {
+}
+
+// Chunks don't move with the pool, views stay valid
+inline StringPool::StringPool(StringPool&& other) noexcept
+: chunkSize(other.chunkSize), deduplicate(other.deduplicate) {
+    *this = std::move(other);
+}
+
+inline StringPool& StringPool::operator=(StringPool&& other) noexcept {
+    if(this != &other) {
+        clear();
+        std::swap(chunks, other.chunks);
+        std::swap(cursor, other.cursor);
+        std::swap(chunkEnd, other.chunkEnd);
+        std::swap(pendingLen, other.pendingLen);
+        std::swap(chunkSize, other.chunkSize);
+        std::swap(deduplicate, other.deduplicate);
+        std::swap(strings, other.strings);
+        std::swap(interned, other.interned);
+        std::swap(stored, other.stored);
+        std::swap(bytes, other.bytes);
+        std::swap(capacity, other.capacity);
+    }
+    return *this;
+}
+
+inline void StringPool::startString() noexcept {
+    pendingLen = 0;
+}
+
+inline char* StringPool::appendString(size_t len) {
+    if(static_cast<size_t>(chunkEnd - cursor) - pendingLen < len) {
+        // Move the pending string to a new chunk, growing ones get room to grow further
+        const auto needed = pendingLen + len;
+        const auto allocSize = std::max(chunkSize, pendingLen ? needed * 2 : needed);
+        chunks.emplace_back(new char[allocSize]);
+        char* chunk = chunks.back().get();
+        if(pendingLen)
+            memcpy(chunk, cursor, pendingLen);
+        cursor = chunk;
+        chunkEnd = chunk + allocSize;
+        capacity += static_cast<int64_t>(allocSize);
+    }
+    char* dst = cursor + pendingLen;
+    pendingLen += len;
+    return dst;
+}
+
+inline char* StringPool::pendingString() noexcept {
+    return cursor;
+}
+
+inline std::string_view StringPool::finishString() {
+    const std::string_view str(cursor, pendingLen);
+    pendingLen = 0;
+    ++interned;
+    if(deduplicate) {
+        const auto [it, inserted] = strings.insert(str);
+        if(!inserted)
+            return *it;
+    }
+    cursor += str.size();
+    bytes += static_cast<int64_t>(str.size());
+    ++stored;
+    return str;
+}
+
+inline std::string_view StringPool::intern(std::string_view str) {
+    startString();
+    if(!str.empty())
+        memcpy(appendString(str.size()), str.data(), str.size());
+    return finishString();
+}
+
+inline bool StringPool::deduplicates() const noexcept {
+    return deduplicate;
+}
+
+inline StringPool::Stats StringPool::stats() const noexcept {
+    return { interned, stored, bytes, capacity };
+}
+
+inline void StringPool::clear() noexcept {
+    strings.clear();
+    chunks.clear();
+    cursor = chunkEnd = nullptr;
+    pendingLen = 0;
+    interned = stored = 0;
+    bytes = capacity = 0;
+}
+
+namespace detail {
+
+template <typename Source>
+template <typename DefaultSource, typename... Args>
+inline SourceHolder<Source>::SourceHolder(std::in_place_type_t<DefaultSource>, Args&&... args)
+: source(std::forward<Args>(args)...) {
+}
+
+template <typename Source>
+inline SourceHolder<Source>::SourceHolder(std::unique_ptr<Source> source)
+: source(std::move(*source)) {
+}
+
+template <typename Source>
+inline Source* SourceHolder<Source>::get() const noexcept {
+    return &source;
+}
+
+template <typename Source>
+inline Source* SourceHolder<Source>::operator->() const noexcept {
+    return &source;
+}
+
+template <typename DefaultSource, typename... Args>
+inline SourceHolder<ISource>::SourceHolder(std::in_place_type_t<DefaultSource>, Args&&... args)
+: source(std::make_unique<DefaultSource>(std::forward<Args>(args)...)) {
+}
+
+inline SourceHolder<ISource>::SourceHolder(std::unique_ptr<ISource> source)
+: source(std::move(source)) {
+}
+
+inline ISource* SourceHolder<ISource>::get() const noexcept {
+    return source.get();
+}
+
+inline ISource* SourceHolder<ISource>::operator->() const noexcept {
+    return source.get();
+}
+
+inline FlagGuard::FlagGuard(bool& flag) noexcept : flag(flag) {
+    flag = true;
+}
+
+inline FlagGuard::~FlagGuard() {
+    flag = false;
+}
+
+template <typename Source>
+template <typename... Args>
+inline OpaqueSourceMixin<Source>::OpaqueSourceMixin(Args&&... args)
+: Source(std::forward<Args>(args)...) {
+}
+
+template <typename Source>
+inline std::unique_ptr<ISource> OpaqueSourceMixin<Source>::clone() const {
+    throw std::runtime_error("Source mixin doesn't support cloning");
+}
+
+template <typename Source>
+inline std::unique_ptr<ISource> OpaqueSourceMixin<Source>::slice(int64_t offset,
+                                                                 int64_t length) const {
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(length);
+    throw std::runtime_error("Source mixin doesn't support slicing");
+}
+
+template <typename Source>
+inline const char* OpaqueSourceMixin<Source>::contiguous(int64_t offset, int64_t len) const
+noexcept {
+    ZBIO_UNUSED(offset);
+    ZBIO_UNUSED(len);
+    return nullptr;
+}
+
+template <typename Source>
+inline int64_t OpaqueSourceMixin<Source>::lendWindow(const char*& ptr) noexcept {
+    ZBIO_UNUSED(ptr);
+    return -1;
 }
 
-inline int64_t FileSource::tell() const noexcept {
-    return ifs.tellg();
+} // namespace detail
+
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(BasicBinaryReader&& other) noexcept
+: source(releaseSource(other)) {
+    refreshWindow();
 }
 
-inline int64_t FileSource::size() const noexcept {
-    return size_;
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(const std::filesystem::path& path)
+: source(std::in_place_type<FileSource>, path) {
+    refreshWindow();
 }
 
-// Non owning constructor
-inline BufferSource::BufferSource(const char* data, int64_t data_size)
-: ownedBuffer(nullptr), buffer(data), bufferSize(data_size), cur(0) {
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(const std::string& path)
+: source(std::in_place_type<FileSource>, path) {
+    refreshWindow();
 }
 
-// Owning constructor
-inline BufferSource::BufferSource(std::unique_ptr<char[]> data, int64_t data_size)
-: ownedBuffer(std::move(data)), buffer(nullptr), bufferSize(data_size), cur(0) {
-    buffer = ownedBuffer.get();
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(const char* path)
+: source(std::in_place_type<FileSource>, path) {
+    refreshWindow();
 }
 
-inline void BufferSource::read(char* dst, int64_t len) {
-    peek(dst, len);
-    cur += len;
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(const char* data, int64_t data_size)
+: source(std::in_place_type<BufferSource>, data, data_size) {
+    refreshWindow();
 }
 
-inline void BufferSource::peek(char* dst, int64_t len) const {
-    if(cur + len > size())
-        throw std::runtime_error("OOR read/peek");
-    memcpy(dst, &(buffer[cur]), len);
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(std::unique_ptr<char[]> data, int64_t data_size)
+: source(std::in_place_type<BufferSource>, std::move(data), data_size) {
+    refreshWindow();
 }
 
-inline void BufferSource::seek(int64_t offset) {
-    if(offset < 0)
-        throw std::runtime_error("negative OOR seek");
-    cur = offset; // Seeking to positive OOB is not an error
+template <typename Source>
+inline BasicBinaryReader<Source>::BasicBinaryReader(std::unique_ptr<Source> source)
+: source(std::move(source)) {
+    refreshWindow();
 }
 
-inline int64_t BufferSource::tell() const noexcept {
-    return cur;
+template <typename Source>
+template <typename... Args>
+inline BasicBinaryReader<Source>::BasicBinaryReader(std::in_place_t, Args&&... args)
+: source(std::in_place_type<Source>, std::forward<Args>(args)...) {
+    refreshWindow();
 }
 
-inline int64_t BufferSource::size() const noexcept {
-    return bufferSize;
+template <typename Source>
+template <typename SourceT, typename... Args>
+inline BasicBinaryReader<Source> BasicBinaryReader<Source>::make(Args&&... args) {
+    if constexpr(std::is_same_v<Source, ISource>) {
+        static_assert(std::is_base_of_v<ISource, SourceT>);
+        return BasicBinaryReader(std::make_unique<SourceT>(std::forward<Args>(args)...));
+    } else {
+        static_assert(std::is_same_v<Source, SourceT>);
+        return BasicBinaryReader(std::in_place, std::forward<Args>(args)...);
+    }
 }
 
-inline BinaryReader::BinaryReader(BinaryReader&& other) noexcept : source(std::move(other.source)) {
+template <typename Source>
+inline BasicBinaryReader<Source>&
+BasicBinaryReader<Source>::operator=(BasicBinaryReader&& other) noexcept {
+    windowBegin = windowCur = windowEnd = nullptr;
+    source = releaseSource(other);
+    lendsWindows = true;
+    refreshWindow();
+    return *this;
 }
 
-inline BinaryReader::BinaryReader(const std::filesystem::path& path)
-: source(std::make_unique<FileSource>(path)) {
+template <typename Source>
+inline void BasicBinaryReader<Source>::refreshWindow() const noexcept {
+    windowBegin = windowCur = windowEnd = nullptr;
+    if(!lendsWindows)
+        return;
+
+    const char* ptr = nullptr;
+    const auto len = source->lendWindow(ptr);
+    if(len < 0) {
+        lendsWindows = false;
+        return;
+    }
+    windowBase = source->tell();
+    windowBegin = windowCur = ptr;
+    windowEnd = ptr + len;
 }
 
-inline BinaryReader::BinaryReader(const std::string& path)
-: source(std::make_unique<FileSource>(path)) {
+// Move the source's read head to the reader's position and drop the window
+template <typename Source>
+inline void BasicBinaryReader<Source>::syncWindow() const {
+    if(windowCur != windowBegin)
+        source->seek(windowBase + (windowCur - windowBegin));
+    windowBegin = windowCur = windowEnd = nullptr;
 }
 
-inline BinaryReader::BinaryReader(const char* path) : source(std::make_unique<FileSource>(path)) {
+template <typename Source>
+inline detail::SourceHolder<Source>&&
+BasicBinaryReader<Source>::releaseSource(BasicBinaryReader& br) {
+    br.syncWindow();
+    return std::move(br.source);
 }
 
-inline BinaryReader::BinaryReader(const char* data, int64_t data_size)
-: source(std::make_unique<BufferSource>(data, data_size)) {
+template <typename Source>
+inline BasicBinaryReader<Source> BasicBinaryReader<Source>::clone() const {
+    syncWindow();
+    auto clone = source->clone();
+    if constexpr(std::is_same_v<Source, ISource>) {
+        return BasicBinaryReader(std::move(clone));
+    } else {
+        // Sources return clones of their own type
+        auto& typedClone = dynamic_cast<Source&>(*clone);
+        return BasicBinaryReader(std::in_place, std::move(typedClone));
+    }
 }
 
-inline BinaryReader::BinaryReader(std::unique_ptr<char[]> data, int64_t data_size)
-: source(std::make_unique<BufferSource>(std::move(data), data_size)) {
+template <typename Source>
+inline BinaryReader BasicBinaryReader<Source>::slice(int64_t offset, int64_t length) const {
+    return BinaryReader(source->slice(offset, length));
 }
 
-inline BinaryReader::BinaryReader(std::unique_ptr<ISource> source) : source(std::move(source)) {
+template <typename Source>
+inline void
+BasicBinaryReader<Source>::advise(AccessHint hint, int64_t offset, int64_t len) noexcept {
+    source->advise(offset, len, hint);
 }
 
-inline BinaryReader& BinaryReader::operator=(BinaryReader&& other) noexcept {
-    source = std::move(other.source);
-    return *this;
+template <typename Source>
+inline void BasicBinaryReader<Source>::prefetch(int64_t offset, int64_t len) noexcept {
+    source->advise(offset, len, AccessHint::WillNeed);
 }
 
-inline int64_t BinaryReader::tell() const noexcept {
+template <typename Source>
+inline int64_t BasicBinaryReader<Source>::tell() const noexcept {
+    if(windowBegin)
+        return windowBase + (windowCur - windowBegin);
     return source->tell();
 }
 
-inline void BinaryReader::seek(int64_t pos) {
+template <typename Source>
+inline void BasicBinaryReader<Source>::seek(int64_t pos) {
+    if(windowBegin && pos >= windowBase && pos <= windowBase + (windowEnd - windowBegin)) {
+        windowCur = windowBegin + (pos - windowBase);
+        return;
+    }
+    windowBegin = windowCur = windowEnd = nullptr; // Seeking replaces the source's read head anyway
     source->seek(pos);
+    refreshWindow();
 }
 
-inline int64_t BinaryReader::size() const noexcept {
+template <typename Source>
+inline int64_t BasicBinaryReader<Source>::size() const noexcept {
     return source->size();
 }
 
+template <typename Source>
+template <typename T, Endianness en>
+inline void BasicBinaryReader<Source>::read(T* arr, int64_t len) {
+    const auto byteLen = static_cast<int64_t>(sizeof(T)) * len;
+    if(byteLen && byteLen <= windowEnd - windowCur) {
+        memcpy(arr, windowCur, byteLen);
+        windowCur += byteLen;
+    } else {
+        syncWindow();
+        source->read(reinterpret_cast<char*>(arr), byteLen);
+        refreshWindow();
+    }
+    if constexpr((en == Endianness::BE) && (sizeof(T) > sizeof(char)))
+        reverseEndiannessArray(arr, len);
+}
+
+template <typename Source>
 template <typename T, Endianness en>
-inline void BinaryReader::read(T* arr, int64_t len) {
-    source->read(reinterpret_cast<char*>(arr), sizeof(T) * len);
-    if constexpr((en == Endianness::BE) && (sizeof(T) > sizeof(char))) {
-        for(int i = 0; i < len; ++i)
-            reverseEndianness(arr[i]);
+inline void BasicBinaryReader<Source>::peek(T* arr, int64_t len) const {
+    const auto byteLen = static_cast<int64_t>(sizeof(T)) * len;
+    if(byteLen && byteLen <= windowEnd - windowCur) {
+        memcpy(arr, windowCur, byteLen);
+    } else {
+        syncWindow();
+        source->peek(reinterpret_cast<char*>(arr), byteLen);
+        refreshWindow();
     }
+    if constexpr((en == Endianness::BE) && (sizeof(T) > sizeof(char)))
+        reverseEndiannessArray(arr, len);
 }
 
+// Served from the lent window if it covers the range, the source is called otherwise
+template <typename Source>
 template <typename T, Endianness en>
-inline void BinaryReader::peek(T* arr, int64_t len) const {
-    source->peek(reinterpret_cast<char*>(arr), sizeof(T) * len);
-    if constexpr((en == Endianness::BE) && (sizeof(T) > sizeof(char))) {
-        for(int i = 0; i < len; ++i)
-            reverseEndianness(arr[i]);
+inline void BasicBinaryReader<Source>::readAt(int64_t offset, T* arr, int64_t len) const {
+    const auto byteLen = static_cast<int64_t>(sizeof(T)) * len;
+    const auto windowLength = windowEnd - windowBegin;
+    if(byteLen && offset >= windowBase && offset + byteLen <= windowBase + windowLength) {
+        memcpy(arr, windowBegin + (offset - windowBase), byteLen);
+    } else {
+        syncWindow();
+        source->readAt(offset, reinterpret_cast<char*>(arr), byteLen);
+        refreshWindow();
     }
+    if constexpr((en == Endianness::BE) && (sizeof(T) > sizeof(char)))
+        reverseEndiannessArray(arr, len);
+}
+
+template <typename Source>
+template <typename T, Endianness en>
+inline T BasicBinaryReader<Source>::readAt(int64_t offset) const {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if constexpr(en == Endianness::BE)
+        static_assert(std::is_fundamental_v<T>);
+
+    T value;
+    readAt<T, en>(offset, &value, 1);
+    return value;
 }
 
+template <typename Source>
 template <typename T, Endianness en>
-inline T BinaryReader::read() {
+inline T BasicBinaryReader<Source>::read() {
     static_assert(std::is_trivially_copyable_v<T>);
 
     if constexpr(en == Endianness::BE)
@@ -299,19 +3473,37 @@ inline T BinaryReader::read() {
     return value;
 }
 
+template <typename Source>
+template <typename T>
+inline void BasicBinaryReader<Source>::readStruct(T* arr, int64_t len) {
+    read(arr, len);
+    reverseEndiannessStructs(arr, len);
+}
+
+template <typename Source>
+template <typename T>
+inline T BasicBinaryReader<Source>::readStruct() {
+    T value;
+    readStruct(&value, 1);
+    return value;
+}
+
+template <typename Source>
 template <typename T>
-inline void BinaryReader::sink(int64_t len) {
+inline void BasicBinaryReader<Source>::sink(int64_t len) {
     for(int i = 0; i < len; ++i)
         static_cast<void>(read<T>());
 }
 
+template <typename Source>
 template <typename T>
-inline void BinaryReader::sink() {
+inline void BasicBinaryReader<Source>::sink() {
     static_cast<void>(read<T>());
 }
 
+template <typename Source>
 template <typename T, Endianness en>
-inline T BinaryReader::peek() const {
+inline T BasicBinaryReader<Source>::peek() const {
     static_assert(std::is_trivially_copyable_v<T>);
 
     T value;
@@ -319,8 +3511,82 @@ inline T BinaryReader::peek() const {
     return value;
 }
 
+template <typename Source>
+template <typename T>
+inline View<T> BasicBinaryReader<Source>::view(int64_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    const auto pos = tell();
+    const auto len = static_cast<int64_t>(sizeof(T)) * count;
+    const char* data = source->contiguous(pos, len);
+    if(data && reinterpret_cast<uintptr_t>(data) % alignof(T) == 0) {
+        seek(pos + len);
+        return View<T>(reinterpret_cast<const T*>(data), count);
+    }
+
+    // Fallback for sources without contiguous memory and misaligned data
+    std::unique_ptr<T[]> copy(new T[count]);
+    read(copy.get(), count);
+    return View<T>(std::move(copy), count);
+}
+
+template <typename Source>
+inline void
+BasicBinaryReader<Source>::readBatch(const ReadRequest* requests, int64_t count, int64_t maxGap) {
+    const auto sourceSize = size();
+    for(int64_t i = 0; i < count; ++i) {
+        const auto& request = requests[i];
+        if(request.offset < 0 || request.length < 0 || request.offset + request.length > sourceSize)
+            throw std::runtime_error("OOR read/peek");
+    }
+
+    // In-memory ranges are copied directly, the rest is read in clusters
+    std::vector<const ReadRequest*> pending;
+    for(int64_t i = 0; i < count; ++i) {
+        const auto& request = requests[i];
+        if(!request.length)
+            continue;
+        if(const char* data = source->contiguous(request.offset, request.length))
+            memcpy(request.dst, data, request.length);
+        else
+            pending.push_back(&request);
+    }
+    if(pending.empty())
+        return;
+
+    std::sort(pending.begin(), pending.end(), [](const ReadRequest* a, const ReadRequest* b) {
+        return a->offset < b->offset;
+    });
+
+    syncWindow();
+    try {
+        std::vector<char> cluster;
+        for(size_t first = 0, last = 0; first < pending.size(); first = last) {
+            const auto begin = pending[first]->offset;
+            auto end = begin + pending[first]->length;
+            for(last = first + 1; last < pending.size() && pending[last]->offset <= end + maxGap;
+                ++last)
+                end = std::max(end, pending[last]->offset + pending[last]->length);
+
+            if(last - first == 1) {
+                source->readAt(begin, pending[first]->dst, end - begin);
+                continue;
+            }
+            cluster.resize(static_cast<size_t>(end - begin));
+            source->readAt(begin, cluster.data(), end - begin);
+            for(auto i = first; i < last; ++i)
+                memcpy(pending[i]->dst, &cluster[pending[i]->offset - begin], pending[i]->length);
+        }
+    } catch(...) {
+        refreshWindow();
+        throw;
+    }
+    refreshWindow();
+}
+
+template <typename Source>
 template <unsigned int len, Endianness en>
-inline std::string BinaryReader::readString() {
+inline std::string BasicBinaryReader<Source>::readString() {
     std::string str(len, '\0');
     read(str.data(), len);
     if constexpr(en == Endianness::LE)
@@ -332,8 +3598,9 @@ inline std::string BinaryReader::readString() {
     return str;
 }
 
+template <typename Source>
 template <Endianness en>
-inline std::string BinaryReader::readString(size_t charCount) {
+inline std::string BasicBinaryReader<Source>::readString(size_t charCount) {
     std::string str(charCount, '\0');
     read(str.data(), charCount);
     if constexpr(en == Endianness::LE)
@@ -341,17 +3608,94 @@ inline std::string BinaryReader::readString(size_t charCount) {
     return str;
 }
 
-template <Endianness en>
-inline std::string BinaryReader::readCString() {
-    std::vector<char> readBuffer;
+template <typename Source>
+inline std::string_view BasicBinaryReader<Source>::readStringView(size_t charCount) {
+    // Streams of unknown size never expose contiguous memory
+    const auto sourceSize = size();
+    if(sourceSize < 0)
+        throw std::runtime_error("Source doesn't expose contiguous memory");
+
+    const auto pos = tell();
+    const auto len = static_cast<int64_t>(charCount);
+    if(pos + len > sourceSize)
+        throw std::runtime_error("OOR read/peek");
+    const char* data = source->contiguous(pos, len);
+    if(!data && len)
+        throw std::runtime_error("Source doesn't expose contiguous memory");
 
-    char c = '\0';
-    do {
-        c = read<char>();
-        readBuffer.push_back(c);
-    } while(c != '\0');
+    seek(pos + len);
+    return std::string_view(data, charCount);
+}
+
+template <typename Source>
+inline std::string_view BasicBinaryReader<Source>::readCStringView() {
+    const auto sourceSize = size();
+    if(sourceSize < 0)
+        throw std::runtime_error("Source doesn't expose contiguous memory");
+
+    const auto pos = tell();
+    const auto remaining = sourceSize - pos;
+    if(remaining <= 0)
+        throw std::runtime_error("OOR read/peek");
+    const char* data = source->contiguous(pos, remaining);
+    if(!data)
+        throw std::runtime_error("Source doesn't expose contiguous memory");
+
+    const auto terminator = static_cast<const char*>(memchr(data, '\0', remaining));
+    if(!terminator)
+        throw std::runtime_error("OOR read/peek");
+    seek(pos + (terminator - data) + 1);
+    return std::string_view(data, terminator - data);
+}
 
-    std::string str(readBuffer.begin(), readBuffer.end() - 1);
+template <typename Source>
+template <typename Append>
+inline void BasicBinaryReader<Source>::scanCString(Append&& append) {
+    constexpr int64_t chunkSize = 0x100;
+
+    // Search the terminator in the lent window or the source's memory if possible, in peeked
+    // chunks otherwise. Streams of unknown size are peeked byte by byte to not read past the end.
+    // Peeked bytes are consumed with a read, which lets buffering sources refill and mixins
+    // observe the string.
+    const auto sourceSize = size();
+    for(;;) {
+        const auto pos = tell();
+        if(sourceSize >= 0 && pos >= sourceSize)
+            throw std::runtime_error("OOR read/peek");
+
+        const char* data = nullptr;
+        int64_t len = 0;
+        char chunk[chunkSize];
+        bool peeked = false;
+        if(windowCur != windowEnd) {
+            data = windowCur;
+            len = windowEnd - windowCur;
+        } else if(sourceSize >= 0 && (data = source->contiguous(pos, sourceSize - pos))) {
+            len = sourceSize - pos;
+        } else {
+            len = sourceSize >= 0 ? std::min(chunkSize, sourceSize - pos) : 1;
+            peek(chunk, len);
+            data = chunk;
+            peeked = true;
+        }
+
+        const auto terminator = static_cast<const char*>(memchr(data, '\0', len));
+        const auto consumed = terminator ? terminator - data + 1 : len;
+        append(data, terminator ? terminator - data : len);
+        if(peeked)
+            read(chunk, consumed);
+        else
+            seek(pos + consumed);
+        if(terminator)
+            break;
+    }
+}
+
+template <typename Source>
+template <Endianness en>
+inline std::string BasicBinaryReader<Source>::readCString() {
+    std::string str;
+    scanCString([&](const char* data, int64_t len) { str.append(data, len); });
 
     if constexpr(en == Endianness::LE)
         reverseEndianness(str);
@@ -359,16 +3703,45 @@ inline std::string BinaryReader::readCString() {
     return str;
 }
 
+template <typename Source>
+template <Endianness en>
+inline std::string_view BasicBinaryReader<Source>::readString(size_t charCount, StringPool& pool) {
+    pool.startString();
+    char* str = pool.appendString(charCount);
+    read(str, charCount);
+    if constexpr(en == Endianness::LE)
+        std::reverse(str, str + charCount);
+    return pool.finishString();
+}
+
+template <typename Source>
+template <Endianness en>
+inline std::string_view BasicBinaryReader<Source>::readCString(StringPool& pool) {
+    pool.startString();
+    size_t len = 0;
+    scanCString([&](const char* data, int64_t pieceLen) {
+        memcpy(pool.appendString(pieceLen), data, pieceLen);
+        len += pieceLen;
+    });
+    if constexpr(en == Endianness::LE) {
+        char* str = pool.pendingString();
+        std::reverse(str, str + len);
+    }
+    return pool.finishString();
+}
+
+template <typename Source>
 template <unsigned int alignment>
-inline void BinaryReader::align() {
+inline void BasicBinaryReader<Source>::align() {
     char zero[alignment];
     uint64_t pos = tell();
     uint64_t padding_len = (alignment - pos) % alignment;
     read(zero, padding_len);
 }
 
+template <typename Source>
 template <unsigned int alignment>
-inline void BinaryReader::alignZeroPad() {
+inline void BasicBinaryReader<Source>::alignZeroPad() {
     char zero[alignment];
     uint64_t pos = tell();
     uint64_t padding_len = (alignment - pos) % alignment;
@@ -380,39 +3753,364 @@ inline void BinaryReader::alignZeroPad() {
         throw std::runtime_error("Non zero padding encountered");
 }
 
-inline const ISource* BinaryReader::getSource() const noexcept {
+template <typename Source>
+inline const Source* BasicBinaryReader<Source>::getSource() const noexcept {
+    syncWindow(); // Keep the source's read head consistent for callers inspecting it
     return source.get();
 }
 
 template <typename Source>
 template <typename... Args>
 inline CoverageTrackingSource<Source>::CoverageTrackingSource(Args&&... args)
-: Source(std::forward<Args>(args)...) {
-    accessPattern.resize(Source::size(), 0);
+: detail::OpaqueSourceMixin<Source>(std::forward<Args>(args)...) {
 }
 
 template <typename Source>
 inline void CoverageTrackingSource<Source>::read(char* dst, int64_t len) {
     auto cur = Source::tell();
     Source::read(dst, len);
-    for(auto i = cur; i < cur + len; ++i) {
-        if(accessPattern[i]++)
-            throw std::runtime_error("Double read");
+    if(!inReadAt)
+        markCovered(cur, cur + len);
+}
+
+template <typename Source>
+inline void CoverageTrackingSource<Source>::readAt(int64_t offset, char* dst, int64_t len) {
+    {
+        detail::FlagGuard guard(inReadAt);
+        Source::readAt(offset, dst, len);
+    }
+    markCovered(offset, offset + len);
+}
+
+template <typename Source>
+inline void CoverageTrackingSource<Source>::markCovered(int64_t begin, int64_t end) {
+    if(begin == end)
+        return;
+
+    auto next = coveredRanges.upper_bound(begin);
+    auto prev = next == coveredRanges.begin() ? coveredRanges.end() : std::prev(next);
+    if((prev != coveredRanges.end() && prev->second > begin) ||
+       (next != coveredRanges.end() && next->first < end))
+        throw std::runtime_error("Double read");
+
+    // Merge with adjacent ranges to keep the map minimal
+    if(prev != coveredRanges.end() && prev->second == begin) {
+        begin = prev->first;
+        coveredRanges.erase(prev);
     }
+    if(next != coveredRanges.end() && next->first == end) {
+        end = next->second;
+        coveredRanges.erase(next);
+    }
+    coveredRanges.emplace(begin, end);
 }
 
 template <typename Source>
-inline bool CoverageTrackingSource<Source>::completeCoverage(const BinaryReader* br) {
+template <typename ReaderSource>
+inline bool
+CoverageTrackingSource<Source>::completeCoverage(const BasicBinaryReader<ReaderSource>* br) {
     auto coverageReader = dynamic_cast<const CoverageTrackingSource<Source>*>(br->getSource());
     return coverageReader->completeCoverageInternal();
 }
 
+template <typename Source>
+template <typename ReaderSource>
+inline std::vector<std::pair<int64_t, int64_t>>
+CoverageTrackingSource<Source>::uncoveredRanges(const BasicBinaryReader<ReaderSource>* br) {
+    auto coverageReader = dynamic_cast<const CoverageTrackingSource<Source>*>(br->getSource());
+    return coverageReader->uncoveredRangesInternal();
+}
+
 template <typename Source>
 inline bool CoverageTrackingSource<Source>::completeCoverageInternal() const {
-    auto it = std::find(accessPattern.begin(), accessPattern.end(), 0);
-    if(it == accessPattern.end())
+    if(!Source::size())
         return true;
-    return false;
+    return coveredRanges.size() == 1 && coveredRanges.begin()->first == 0 &&
+           coveredRanges.begin()->second >= Source::size();
+}
+
+template <typename Source>
+inline std::vector<std::pair<int64_t, int64_t>>
+CoverageTrackingSource<Source>::uncoveredRangesInternal() const {
+    std::vector<std::pair<int64_t, int64_t>> uncovered;
+    int64_t pos = 0;
+    for(const auto& [begin, end] : coveredRanges) {
+        if(begin > pos)
+            uncovered.emplace_back(pos, begin);
+        pos = end;
+    }
+    if(pos < Source::size())
+        uncovered.emplace_back(pos, Source::size());
+    return uncovered;
+}
+
+inline void OperationMetrics::record(uint64_t byteCount, uint64_t ns) noexcept {
+    ++calls;
+    bytes += byteCount;
+    nanoseconds += ns;
+
+    int bucket = 0;
+    while(ns >>= 1)
+        ++bucket;
+    ++latency[std::min(bucket, bucketCount - 1)];
+}
+
+template <typename Source>
+template <typename... Args>
+inline InstrumentedSource<Source>::InstrumentedSource(Args&&... args)
+: detail::OpaqueSourceMixin<Source>(std::forward<Args>(args)...) {
+}
+
+template <typename Source>
+inline uint64_t InstrumentedSource<Source>::elapsed(Clock::time_point start) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Failed calls are recorded as well, they took time too
+template <typename Source>
+inline void InstrumentedSource<Source>::read(char* dst, int64_t len) {
+    if(inReadAt)
+        return Source::read(dst, len);
+
+    const auto start = Clock::now();
+    try {
+        Source::read(dst, len);
+    } catch(...) {
+        metrics_.read.record(0, elapsed(start));
+        throw;
+    }
+    metrics_.read.record(len, elapsed(start));
+}
+
+// Positional reads are counted as reads
+template <typename Source>
+inline void InstrumentedSource<Source>::readAt(int64_t offset, char* dst, int64_t len) {
+    const auto start = Clock::now();
+    try {
+        detail::FlagGuard guard(inReadAt);
+        Source::readAt(offset, dst, len);
+    } catch(...) {
+        metrics_.read.record(0, elapsed(start));
+        throw;
+    }
+    metrics_.read.record(len, elapsed(start));
+}
+
+template <typename Source>
+inline void InstrumentedSource<Source>::peek(char* dst, int64_t len) const {
+    const auto start = Clock::now();
+    try {
+        Source::peek(dst, len);
+    } catch(...) {
+        metrics_.peek.record(0, elapsed(start));
+        throw;
+    }
+    metrics_.peek.record(len, elapsed(start));
+}
+
+template <typename Source>
+inline void InstrumentedSource<Source>::seek(int64_t offset) {
+    if(inReadAt)
+        return Source::seek(offset);
+
+    const auto from = Source::tell();
+    const auto start = Clock::now();
+    Source::seek(offset);
+    metrics_.seek.record(offset < from ? from - offset : offset - from, elapsed(start));
+    if(offset < from)
+        ++metrics_.backwardSeeks;
+}
+
+template <typename Source>
+inline SourceMetrics InstrumentedSource<Source>::getMetrics() const noexcept {
+    return metrics_;
+}
+
+template <typename Source>
+inline void InstrumentedSource<Source>::resetMetrics() noexcept {
+    metrics_ = {};
+}
+
+template <typename Source>
+template <typename ReaderSource>
+inline SourceMetrics
+InstrumentedSource<Source>::metrics(const BasicBinaryReader<ReaderSource>* br) {
+    auto source = dynamic_cast<const InstrumentedSource<Source>*>(br->getSource());
+    if(!source)
+        throw std::runtime_error("Reader source isn't instrumented");
+    return source->getMetrics();
+}
+
+inline AccessTrace::AccessTrace(int64_t sourceSize) noexcept : sourceSize_(sourceSize) {
+}
+
+// Consecutive reads are merged into one access
+inline void AccessTrace::record(int64_t offset, int64_t length) {
+    if(length <= 0)
+        return;
+    if(!accesses_.empty() && accesses_.back().offset + accesses_.back().length == offset)
+        accesses_.back().length += length;
+    else
+        accesses_.push_back({ offset, length });
+}
+
+inline const std::vector<AccessTrace::Access>& AccessTrace::accesses() const noexcept {
+    return accesses_;
+}
+
+inline int64_t AccessTrace::sourceSize() const noexcept {
+    return sourceSize_;
+}
+
+inline std::vector<char> AccessTrace::serialize() const {
+    std::vector<char> data(std::begin(magic), std::end(magic));
+    const auto writeVarint = [&](uint64_t value) {
+        for(; value >= 0x80; value >>= 7)
+            data.push_back(static_cast<char>(value | 0x80));
+        data.push_back(static_cast<char>(value));
+    };
+
+    writeVarint(sourceSize_);
+    writeVarint(accesses_.size());
+    int64_t end = 0;
+    for(const auto& access : accesses_) {
+        // Zigzag encoded, backward jumps are as cheap as forward ones
+        const auto delta = static_cast<uint64_t>(access.offset - end);
+        writeVarint((delta << 1) ^ (access.offset < end ? ~uint64_t(0) : 0));
+        writeVarint(access.length);
+        end = access.offset + access.length;
+    }
+    return data;
+}
+
+inline AccessTrace AccessTrace::deserialize(const char* data, int64_t size) {
+    if(size < static_cast<int64_t>(sizeof(magic)) || memcmp(data, magic, sizeof(magic)))
+        throw std::runtime_error("Invalid trace");
+
+    int64_t pos = sizeof(magic);
+    const auto readVarint = [&]() {
+        uint64_t value = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+            if(pos >= size)
+                break;
+            const auto byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Invalid trace");
+    };
+
+    AccessTrace trace(static_cast<int64_t>(readVarint()));
+    const auto count = readVarint();
+    if(count > static_cast<uint64_t>(size - pos) / 2)
+        throw std::runtime_error("Invalid trace"); // Every access takes at least two bytes
+    trace.accesses_.reserve(count);
+    int64_t end = 0;
+    for(uint64_t i = 0; i < count; ++i) {
+        const auto zigzag = readVarint();
+        const auto offset = end + static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        const auto length = static_cast<int64_t>(readVarint());
+        trace.accesses_.push_back({ offset, length });
+        end = offset + length;
+    }
+    return trace;
+}
+
+template <typename Source>
+template <typename... Args>
+inline TraceRecordingSource<Source>::TraceRecordingSource(Args&&... args)
+: detail::OpaqueSourceMixin<Source>(std::forward<Args>(args)...), trace_(Source::size()) {
+}
+
+template <typename Source>
+inline void TraceRecordingSource<Source>::read(char* dst, int64_t len) {
+    const auto cur = Source::tell();
+    Source::read(dst, len);
+    if(!inReadAt)
+        trace_.record(cur, len);
+}
+
+template <typename Source>
+inline void TraceRecordingSource<Source>::readAt(int64_t offset, char* dst, int64_t len) {
+    {
+        detail::FlagGuard guard(inReadAt);
+        Source::readAt(offset, dst, len);
+    }
+    trace_.record(offset, len);
+}
+
+template <typename Source>
+inline const AccessTrace& TraceRecordingSource<Source>::getTrace() const noexcept {
+    return trace_;
+}
+
+template <typename Source>
+template <typename ReaderSource>
+inline AccessTrace TraceRecordingSource<Source>::trace(const BasicBinaryReader<ReaderSource>* br) {
+    auto source = dynamic_cast<const TraceRecordingSource<Source>*>(br->getSource());
+    if(!source)
+        throw std::runtime_error("Reader source isn't traced");
+    return source->getTrace();
+}
+
+template <typename Source>
+template <typename... Args>
+inline TracePrefetchSource<Source>::TracePrefetchSource(AccessTrace trace, Args&&... args)
+: detail::OpaqueSourceMixin<Source>(std::forward<Args>(args)...),
+  trace(std::move(trace)),
+  lookahead(defaultLookahead) {
+    if(this->trace.sourceSize() != Source::size())
+        this->trace = AccessTrace();
+
+    traceBytes.reserve(this->trace.accesses().size() + 1);
+    traceBytes.push_back(0);
+    for(const auto& access : this->trace.accesses())
+        traceBytes.push_back(traceBytes.back() + access.length);
+}
+
+template <typename Source>
+inline void TracePrefetchSource<Source>::setLookahead(int64_t bytes) noexcept {
+    lookahead = bytes;
+}
+
+// Move to the access containing 'offset' if it's coming up in the trace and hint the following
+// accesses within the lookahead
+template <typename Source>
+inline void TracePrefetchSource<Source>::progress(int64_t offset) noexcept {
+    const auto& accesses = trace.accesses();
+    const auto searchEnd = std::min(accesses.size(), current + searchDistance);
+    for(auto i = current; i < searchEnd; ++i) {
+        if(offset >= accesses[i].offset && offset < accesses[i].offset + accesses[i].length) {
+            current = i;
+            break;
+        }
+    }
+
+    prefetched = std::max(prefetched, current);
+    while(prefetched < accesses.size() &&
+          traceBytes[prefetched] - traceBytes[current] < lookahead) {
+        const auto& access = accesses[prefetched++];
+        Source::advise(access.offset, access.length, AccessHint::WillNeed);
+    }
+}
+
+template <typename Source>
+inline void TracePrefetchSource<Source>::read(char* dst, int64_t len) {
+    progress(Source::tell());
+    Source::read(dst, len);
+}
+
+template <typename Source>
+inline void TracePrefetchSource<Source>::readAt(int64_t offset, char* dst, int64_t len) {
+    progress(offset);
+    Source::readAt(offset, dst, len);
+}
+
+template <typename Source>
+inline void TracePrefetchSource<Source>::seek(int64_t offset) {
+    Source::seek(offset);
+    progress(offset);
 }
 
 } // namespace ZBinaryReader
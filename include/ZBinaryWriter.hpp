@@ -71,6 +71,10 @@ class BinaryWriter {
 private:
     std::unique_ptr<ISink> sink;
 
+    // Write copies of 'arr' converted by 'convert' in chunks, one sink write per chunk
+    template <typename T, typename Convert>
+    void writeConverted(const T* arr, int64_t len, Convert&& convert);
+
 public:
     explicit BinaryWriter(const BinaryWriter& bw) = delete;
     explicit BinaryWriter(BinaryWriter&& bw) noexcept;
@@ -95,6 +99,14 @@ public:
     template <typename T, Endianness en = Endianness::LE>
     void write(const T* arr, int64_t arr_len);
 
+    // Write structs described by a StructLayout with one sink write per chunk, the fields stored
+    // big endian are swapped in a copy
+    template <typename T>
+    void writeStruct(const T& value);
+
+    template <typename T>
+    void writeStruct(const T* arr, int64_t arr_len);
+
     template <unsigned int al = 0x10>
     void align();
 
@@ -241,16 +253,45 @@ inline void BinaryWriter::write(const T* arr, int64_t len) {
     static_assert(std::is_trivially_copyable_v<T>);
 
     if constexpr(en == Endianness::BE) {
-        for(int64_t i = 0; i < len; ++i) {
-            T valueBe = arr[i];
-            reverseEndianness(valueBe);
-            sink->write(reinterpret_cast<const char*>(&valueBe), sizeof(T));
-        }
+        writeConverted(arr, len, [](T* chunk, int64_t n) { reverseEndiannessArray(chunk, n); });
     } else if constexpr(en == Endianness::LE) {
         sink->write(reinterpret_cast<const char*>(arr), len * sizeof(T));
     }
 }
 
+template <typename T, typename Convert>
+inline void BinaryWriter::writeConverted(const T* arr, int64_t len, Convert&& convert) {
+    constexpr int64_t chunkLen = std::max<int64_t>(0x10000 / sizeof(T), 1);
+    std::vector<T> chunk(static_cast<size_t>(std::min(len, chunkLen)));
+    for(int64_t i = 0; i < len; i += chunkLen) {
+        const auto n = std::min(len - i, chunkLen);
+        std::copy(arr + i, arr + i + n, chunk.begin());
+        convert(chunk.data(), n);
+        sink->write(reinterpret_cast<const char*>(chunk.data()), n * sizeof(T));
+    }
+}
+
+template <typename T>
+inline void BinaryWriter::writeStruct(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if constexpr(StructLayout<T>::hasBigEndianFields) {
+        T valueStored = value;
+        reverseEndiannessStructs(&valueStored, 1);
+        sink->write(reinterpret_cast<const char*>(&valueStored), sizeof(T));
+    } else {
+        sink->write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+template <typename T>
+inline void BinaryWriter::writeStruct(const T* arr, int64_t len) {
+    if constexpr(StructLayout<T>::hasBigEndianFields)
+        writeConverted(arr, len, [](T* chunk, int64_t n) { reverseEndiannessStructs(chunk, n); });
+    else
+        sink->write(reinterpret_cast<const char*>(arr), len * sizeof(T));
+}
+
 
 template <unsigned int al>
 inline void BinaryWriter::align() {
@@ -1,9 +1,28 @@
 #include "ZBinaryReader.hpp"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 using namespace ZBio;
 using namespace ZBio::ZBinaryReader;
 
+struct MixedEndianRecord {
+    uint32_t id;
+    uint16_t flags;
+    char tag[2];
+    double weight;
+    float position[3];
+    int32_t le;
+};
+
+template <>
+struct ZBio::StructLayout<MixedEndianRecord>
+: Layout<Field<&MixedEndianRecord::id, Endianness::BE>,
+         Field<&MixedEndianRecord::flags, Endianness::BE>,
+         Field<&MixedEndianRecord::weight, Endianness::BE>,
+         Field<&MixedEndianRecord::position, Endianness::BE>,
+         Field<&MixedEndianRecord::le, Endianness::LE>> {};
+
 namespace {
 
 struct TriviallyCopyableStruct {
@@ -54,11 +73,19 @@ std::filesystem::path getTmpTestDataFilePath() {
     return std::filesystem::temp_directory_path() / "testData.bin";
 }
 
+// Sources constructed from a path to the temporary test data file
+template <typename Source>
+constexpr bool isFileBackedSource = !std::is_same_v<Source, BufferSource>;
+
+// Sources exposing their data as contiguous memory
+template <typename Source>
+constexpr bool isInMemorySource = std::is_base_of_v<BufferSource, Source>;
+
 template <typename Source>
 class BinaryReaderTestFixture : public testing::Test {
 protected:
     static void SetUpTestSuite() {
-        if constexpr(std::is_same_v<Source, FileSource>) {
+        if constexpr(isFileBackedSource<Source>) {
             const auto path = getTmpTestDataFilePath();
             if(path.empty())
                 throw std::runtime_error("Failed to contruct temp path for testData file");
@@ -85,7 +112,8 @@ protected:
         } else if constexpr(std::is_same_v<Source, FileSource>)
             br = std::make_unique<BinaryReader>(getTmpTestDataFilePath());
         else
-            throw; // unreachable;
+            br = std::make_unique<BinaryReader>(
+            BinaryReader::make<Source>(getTmpTestDataFilePath()));
     }
 
     template <typename ReadT>
@@ -147,10 +175,80 @@ protected:
 
 using testing::Types;
 
-typedef Types<FileSource, BufferSource> Implementations;
+#if defined(ZBIO_HAS_IO_URING)
+typedef Types<FileSource,
+              BufferSource,
+              MmapSource,
+              BufferedFileSource,
+              PreadSource,
+              DirectFileSource,
+              UringFileSource,
+              CachedSource,
+              ReadAheadSource>
+Implementations;
+#elif defined(ZBIO_HAS_POSIX_IO)
+typedef Types<FileSource,
+              BufferSource,
+              MmapSource,
+              BufferedFileSource,
+              PreadSource,
+              DirectFileSource,
+              CachedSource,
+              ReadAheadSource>
+Implementations;
+#else
+typedef Types<FileSource, BufferSource, CachedSource, ReadAheadSource> Implementations;
+#endif
 
 TYPED_TEST_SUITE(BinaryReaderTestFixture, Implementations);
 
+// Readers holding a concrete source by value, see BasicBinaryReader
+template <typename Source>
+class StaticReaderTestFixture : public BinaryReaderTestFixture<Source> {
+protected:
+    static BasicBinaryReader<Source> makeReader() {
+        if constexpr(isFileBackedSource<Source>)
+            return BasicBinaryReader<Source>::template make<Source>(getTmpTestDataFilePath());
+        else
+            return BasicBinaryReader<Source>::template make<Source>(testData, sizeof(testData));
+    }
+};
+
+#ifdef ZBIO_HAS_POSIX_IO
+typedef Types<BufferSource, FileSource, MmapSource> StaticImplementations;
+#else
+typedef Types<BufferSource, FileSource> StaticImplementations;
+#endif
+
+TYPED_TEST_SUITE(StaticReaderTestFixture, StaticImplementations);
+
+TYPED_TEST(StaticReaderTestFixture, MoveCtor) {
+    auto br0 = this->makeReader();
+    ZBIO_UNUSED(br0.template read<int16_t>());
+    BasicBinaryReader<TypeParam> br1(std::move(br0));
+    ASSERT_EQ(br1.tell(), 2);
+    ASSERT_EQ(br1.template read<int32_t>(), safeCharArrayCast<int32_t>(&testData[2]));
+}
+
+TYPED_TEST(StaticReaderTestFixture, MoveAssign) {
+    auto br0 = this->makeReader();
+    br0.seek(4);
+    auto br1 = this->makeReader();
+    br1 = std::move(br0);
+    ASSERT_EQ(br1.tell(), 4);
+    ASSERT_EQ(br1.template read<int32_t>(), safeCharArrayCast<int32_t>(&testData[4]));
+}
+
+TYPED_TEST(StaticReaderTestFixture, Clone) {
+    auto br0 = this->makeReader();
+    br0.seek(6);
+    auto br1 = br0.clone();
+    ASSERT_EQ(br1.tell(), 6);
+    ASSERT_EQ(br1.template read<int64_t>(), safeCharArrayCast<int64_t>(&testData[6]));
+    ASSERT_EQ(br0.tell(), 6);
+    ASSERT_EQ(br0.template read<int16_t>(), safeCharArrayCast<int16_t>(&testData[6]));
+}
+
 TYPED_TEST(BinaryReaderTestFixture, SourceSize) {
     ASSERT_EQ(this->br->size(), sizeof(testData));
 }
@@ -403,6 +501,171 @@ TYPED_TEST(BinaryReaderTestFixture, AlignmentZeroPadBadPadding) {
     ASSERT_THROW(this->br->alignZeroPad(), std::runtime_error);
 }
 
+TYPED_TEST(BinaryReaderTestFixture, Clone) {
+    using T = int;
+    this->br->seek(4);
+    auto clone = this->br->clone();
+    ASSERT_EQ(clone.tell(), 4);
+
+    // Both readers move independently
+    ASSERT_EQ(clone.template read<T>(), safeCharArrayCast<T>(&testData[4]));
+    ASSERT_EQ(this->br->tell(), 4);
+    this->br->seek(0);
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[0]));
+    ASSERT_EQ(clone.tell(), 4 + sizeof(T));
+}
+
+TYPED_TEST(BinaryReaderTestFixture, View) {
+    constexpr int stringsOffset = 0x1C;
+    constexpr int testStrLen = 4;
+    this->br->seek(stringsOffset);
+
+    const auto str = this->br->view(testStrLen);
+    ASSERT_EQ(str.size(), testStrLen);
+    ASSERT_FALSE(memcmp(str.data(), "Test", testStrLen));
+    ASSERT_EQ(this->br->tell(), stringsOffset + testStrLen);
+
+    // Only in-memory sources can hand out borrowed views
+    ASSERT_EQ(str.isBorrowed(), isInMemorySource<TypeParam>);
+
+    this->br->seek(stringsOffset);
+    if constexpr(isInMemorySource<TypeParam>) {
+        ASSERT_EQ(this->br->readStringView(testStrLen), "Test");
+    } else {
+        ASSERT_THROW(ZBIO_UNUSED(this->br->readStringView(testStrLen)), std::runtime_error);
+    }
+
+    this->br->seek(0);
+    const auto ints = this->br->template view<int32_t>(4);
+    for(int i = 0; i < 4; ++i)
+        ASSERT_EQ(ints[i], safeCharArrayCast<int32_t>(&testData[i * sizeof(int32_t)]));
+
+    this->br->seek(sizeof(testData) - 1);
+    ASSERT_THROW(ZBIO_UNUSED(this->br->view(2)), std::runtime_error);
+}
+
+TYPED_TEST(BinaryReaderTestFixture, Slice) {
+    constexpr int stringsOffset = 0x1C;
+    constexpr int sliceLen = 0x0D;
+
+    this->br->seek(3);
+    auto slice = this->br->slice(stringsOffset, sliceLen);
+    ASSERT_EQ(this->br->tell(), 3);
+    ASSERT_EQ(slice.size(), sliceLen);
+    ASSERT_EQ(slice.tell(), 0);
+    ASSERT_STREQ(slice.template readString<4>().c_str(), "Test");
+    ASSERT_STREQ(slice.template readString<4>().c_str(), "tseT");
+
+    // Reads are bounded by the slice
+    slice.seek(sliceLen - 2);
+    ASSERT_THROW(ZBIO_UNUSED(slice.template read<int32_t>()), std::runtime_error);
+    slice.seek(sliceLen + 1);
+    ASSERT_EQ(slice.tell(), sliceLen + 1);
+
+    // Nested slices are relative to their parent slice
+    auto nested = slice.slice(8, 5);
+    ASSERT_STREQ(nested.readCString().c_str(), "Test");
+    ASSERT_EQ(nested.tell(), 5);
+    ASSERT_THROW(ZBIO_UNUSED(nested.template read<char>()), std::runtime_error);
+
+    // Slices outlive their parent reader
+    this->br.reset();
+    slice.seek(0);
+    ASSERT_STREQ(slice.template readString<4>().c_str(), "Test");
+
+    ASSERT_THROW(ZBIO_UNUSED(slice.slice(4, sliceLen)), std::runtime_error);
+    ASSERT_THROW(ZBIO_UNUSED(slice.slice(-1, 1)), std::runtime_error);
+}
+
+TYPED_TEST(BinaryReaderTestFixture, ReadAt) {
+    this->br->seek(5);
+    ZBIO_UNUSED(this->br->template peek<int32_t>());
+
+    ASSERT_EQ(this->br->template readAt<int32_t>(0x10),
+              safeCharArrayCast<int32_t>(&testData[0x10]));
+    ASSERT_EQ(this->br->template readAt<int16_t>(6), safeCharArrayCast<int16_t>(&testData[6]));
+    auto be = safeCharArrayCast<int32_t>(&testData[1]);
+    reverseEndianness(be);
+    ASSERT_EQ((this->br->template readAt<int32_t, Endianness::BE>(1)), be);
+
+    char buf[sizeof(testData)]{};
+    this->br->readAt(0, buf, sizeof(testData));
+    ASSERT_FALSE(memcmp(buf, testData, sizeof(testData)));
+    ASSERT_EQ(this->br->tell(), 5);
+    ASSERT_EQ(this->br->template read<int32_t>(), safeCharArrayCast<int32_t>(&testData[5]));
+
+    ASSERT_THROW(ZBIO_UNUSED(this->br->template readAt<int32_t>(sizeof(testData) - 3)),
+                 std::runtime_error);
+    ASSERT_THROW(ZBIO_UNUSED(this->br->template readAt<char>(-1)), std::runtime_error);
+    ASSERT_EQ(this->br->tell(), 9);
+}
+
+TYPED_TEST(BinaryReaderTestFixture, ReadBatch) {
+    this->br->seek(3);
+    ZBIO_UNUSED(this->br->template peek<int32_t>()); // Populate a lent window
+
+    // Unsorted, overlapping, adjacent and distant requests
+    constexpr int64_t offsets[] = { 0x20, 1, 0x22, 0x0C, 0x10, 0 };
+    constexpr int64_t lengths[] = { 4, 2, 6, 4, 1, 0 };
+    char results[std::size(offsets)][8]{};
+    std::vector<ReadRequest> requests;
+    for(size_t i = 0; i < std::size(offsets); ++i)
+        requests.push_back({ offsets[i], lengths[i], results[i] });
+
+    for(const int64_t maxGap : { 0, 2, 0x100 }) {
+        this->br->readBatch(requests.data(), requests.size(), maxGap);
+        for(size_t i = 0; i < std::size(offsets); ++i)
+            ASSERT_FALSE(memcmp(results[i], &testData[offsets[i]], lengths[i]));
+        ASSERT_EQ(this->br->tell(), 3);
+    }
+    ASSERT_EQ(this->br->template read<int32_t>(), safeCharArrayCast<int32_t>(&testData[3]));
+
+    requests.push_back({ sizeof(testData) - 1, 2, results[0] });
+    ASSERT_THROW(this->br->readBatch(requests.data(), requests.size()), std::runtime_error);
+}
+
+// Hints must never change what's read
+TYPED_TEST(BinaryReaderTestFixture, AccessHints) {
+    using T = int32_t;
+    this->br->advise(AccessHint::Sequential);
+    this->br->prefetch(0, sizeof(testData));
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[0]));
+
+    this->br->advise(AccessHint::Random, 4, 8);
+    this->br->advise(AccessHint::DontNeed);
+    this->br->advise(AccessHint::Normal, sizeof(testData) + 1, 8); // Past the end is ignored
+    this->br->prefetch(-1, 4);
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[4]));
+
+    auto slice = this->br->slice(8, 8);
+    slice.prefetch(0, 0);
+    slice.advise(AccessHint::WillNeed, 4, 64);
+    ASSERT_EQ(slice.template read<T>(), safeCharArrayCast<T>(&testData[8]));
+}
+
+// Reads served from a lent window have to keep the reader and its source consistent
+TYPED_TEST(BinaryReaderTestFixture, SourcePositionSync) {
+    using T = int16_t;
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[0]));
+    ASSERT_EQ(this->br->template peek<T>(), safeCharArrayCast<T>(&testData[2]));
+    ASSERT_EQ(this->br->getSource()->tell(), sizeof(T));
+
+    this->br->seek(1);
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[1]));
+    ASSERT_EQ(this->br->tell(), 1 + sizeof(T));
+
+    // Large read past the window, followed by small reads again
+    char buf[0x20]{};
+    this->br->read(buf, sizeof(buf));
+    ASSERT_FALSE(memcmp(buf, &testData[1 + sizeof(T)], sizeof(buf)));
+    ASSERT_EQ(this->br->template read<T>(), safeCharArrayCast<T>(&testData[0x23]));
+    ASSERT_EQ(this->br->getSource()->tell(), this->br->tell());
+
+    auto moved = std::move(*this->br);
+    ASSERT_EQ(moved.tell(), 0x23 + sizeof(T));
+    ASSERT_EQ(moved.template read<T>(), safeCharArrayCast<T>(&testData[0x25]));
+}
+
 // Throw if padding contains non-zero values.
 TYPED_TEST(BinaryReaderTestFixture, GetSource) {
     auto source = this->br->getSource();
@@ -488,6 +751,29 @@ TEST_F(BinaryReaderSpecialMemberFunctions, FromSourceCtor) {
     ZBIO_UNUSED(br0.tell());
 }
 
+#ifdef ZBIO_HAS_POSIX_IO
+TEST_F(BinaryReaderSpecialMemberFunctions, MakeMmapSource) {
+    auto br = BinaryReader::make<MmapSource>(tmpFile);
+    ASSERT_EQ(br.size(), std::filesystem::file_size(tmpFile));
+}
+
+TEST_F(BinaryReaderSpecialMemberFunctions, MmapSourceInvalidFile) {
+    ASSERT_THROW(MmapSource(tmpFile / "bad"), std::exception);
+}
+#endif
+
+TEST_F(BinaryReaderSpecialMemberFunctions, OwningBufferClone) {
+    constexpr int bufSize = 4;
+    auto buf = std::make_unique<char[]>(bufSize);
+    buf[3] = 1;
+
+    std::optional<BinaryReader> br0(BinaryReader(std::move(buf), bufSize));
+    auto br1 = br0->clone();
+    br0.reset(); // Clone keeps the owned buffer alive
+    br1.seek(3);
+    ASSERT_EQ(br1.read<char>(), 1);
+}
+
 TEST_F(BinaryReaderSpecialMemberFunctions, MoveAssign) {
     BinaryReader br0(tmpFile);
     BinaryReader br1(tmpFile);
@@ -495,6 +781,724 @@ TEST_F(BinaryReaderSpecialMemberFunctions, MoveAssign) {
     ZBIO_UNUSED(br1.tell());
 }
 
+// Readers over the same file share blocks through the cache
+TEST_F(BinaryReaderSpecialMemberFunctions, CachedSourceSharing) {
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        ofs.write(testData, sizeof(testData));
+    }
+
+    constexpr int64_t blockSize = 8;
+    const auto cache = std::make_shared<BlockCache>(2 * blockSize, blockSize);
+    auto br0 = BinaryReader::make<CachedSource>(tmpFile, cache);
+    auto br1 = BinaryReader::make<CachedSource>(tmpFile, cache);
+
+    char buf[sizeof(testData)]{};
+    br0.read(buf, 12); // Blocks 0 and 1
+    ASSERT_FALSE(memcmp(buf, testData, 12));
+    br1.read(buf, 12);
+    ASSERT_FALSE(memcmp(buf, testData, 12));
+    auto stats = cache->stats();
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.blocks, 2);
+
+    // Block 2 evicts block 0, the least recently used one
+    br1.seek(2 * blockSize);
+    ASSERT_EQ(br1.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[2 * blockSize]));
+    br0.seek(blockSize);
+    ASSERT_EQ(br0.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[blockSize]));
+    stats = cache->stats();
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_EQ(stats.bytes, 2 * blockSize);
+
+    br0.seek(0);
+    br0.read(buf, sizeof(testData));
+    ASSERT_FALSE(memcmp(buf, testData, sizeof(testData)));
+    ASSERT_THROW(ZBIO_UNUSED(br0.read<char>()), std::runtime_error);
+}
+
+// Shards of testData, including an empty one, read back as one source
+TEST_F(BinaryReaderSpecialMemberFunctions, ConcatSourceShards) {
+    constexpr int64_t shardSizes[] = { 7, 0, 16, sizeof(testData) - 23 };
+    std::vector<std::filesystem::path> paths;
+    int64_t offset = 0;
+    for(const auto shardSize : shardSizes) {
+        paths.push_back(tmpFile.string() + "." + std::to_string(paths.size()));
+        std::ofstream ofs(paths.back(), std::ios::binary);
+        ofs.write(&testData[offset], shardSize);
+        offset += shardSize;
+    }
+
+    {
+        auto br = BinaryReader::make<ConcatSource>(paths);
+        ASSERT_EQ(br.size(), sizeof(testData));
+
+        char buf[sizeof(testData)]{};
+        br.read(buf, 5);
+        ASSERT_EQ(br.peek<int32_t>(), safeCharArrayCast<int32_t>(&testData[5]));
+        br.read(buf + 5, sizeof(testData) - 5);
+        ASSERT_FALSE(memcmp(buf, testData, sizeof(testData)));
+        ASSERT_THROW(ZBIO_UNUSED(br.read<char>()), std::runtime_error);
+
+        br.seek(21);
+        auto clone = br.clone();
+        ASSERT_EQ(clone.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[21]));
+        ASSERT_EQ(clone.tell(), 25);
+    }
+
+    for(const auto& path : paths)
+        std::filesystem::remove(path);
+}
+
+TEST(ConcatSource, BufferParts) {
+    std::vector<std::unique_ptr<ISource>> parts;
+    parts.push_back(std::make_unique<BufferSource>(&testData[0], 10));
+    parts.push_back(std::make_unique<BufferSource>(&testData[10], sizeof(testData) - 10));
+    ConcatSource source(std::move(parts));
+    ASSERT_EQ(source.partCount(), 2);
+
+    ASSERT_EQ(source.contiguous(10, 4), &testData[10]);
+    ASSERT_EQ(source.contiguous(8, 4), nullptr);
+
+    BinaryReader br(std::make_unique<ConcatSource>(std::move(source)));
+    br.seek(8);
+    ASSERT_EQ(br.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[8]));
+    const auto view = br.view(4);
+    ASSERT_TRUE(view.isBorrowed());
+    ASSERT_FALSE(memcmp(view.data(), &testData[12], 4));
+}
+
+// Peeks straddling blocks and seeks inside and outside of the read-ahead range
+TEST(ReadAheadSource, SmallBlocks) {
+    constexpr int64_t blockSize = 4;
+    auto br = BinaryReader::make<ReadAheadSource>(
+    std::make_unique<BufferSource>(testData, sizeof(testData)), blockSize);
+
+    char buf[sizeof(testData)]{};
+    int64_t off = 0;
+    for(const int64_t len : { 1, 3, 4, 2, 8, 5, 1, 7 }) {
+        br.peek(buf, 6);
+        ASSERT_FALSE(memcmp(buf, &testData[off], 6));
+        br.read(buf, len);
+        ASSERT_FALSE(memcmp(buf, &testData[off], len));
+        off += len;
+    }
+
+    for(const int64_t offset : { int64_t(2), int64_t(30), int64_t(34), int64_t(9) }) {
+        br.seek(offset);
+        ASSERT_EQ(br.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[offset]));
+    }
+
+    br.seek(0);
+    br.read(buf, sizeof(testData));
+    ASSERT_FALSE(memcmp(buf, testData, sizeof(testData)));
+    ASSERT_THROW(ZBIO_UNUSED(br.read<char>()), std::runtime_error);
+}
+
+#ifdef ZBIO_HAS_POSIX_IO
+class PosixSourceTestFixture : public BinaryReaderSpecialMemberFunctions {
+protected:
+    void SetUp() override {
+        this->tmpFile = std::filesystem::temp_directory_path() / "PosixSourceTmpFile.bin";
+
+        std::ofstream ofs(tmpFile, std::ios::binary);
+        if(!ofs.is_open())
+            throw;
+        ofs.write(testData, sizeof(testData));
+        ofs.close();
+    }
+};
+
+// Reads straddling, filling and bypassing a tiny read-ahead window
+TEST_F(PosixSourceTestFixture, SmallWindow) {
+    constexpr int64_t windowSize = 5;
+    BufferedFileSource source(tmpFile, windowSize);
+
+    char buf[sizeof(testData)]{};
+    int64_t off = 0;
+    for(const int64_t len : { 1, 3, 4, 2, 8, 5, 16, 1, 7 }) {
+        source.read(buf, len);
+        ASSERT_FALSE(memcmp(buf, &testData[off], len));
+        off += len;
+        ASSERT_EQ(source.tell(), off);
+    }
+
+    source.seek(2);
+    source.peek(buf, 10);
+    ASSERT_FALSE(memcmp(buf, &testData[2], 10));
+    source.read(buf, 2);
+    ASSERT_FALSE(memcmp(buf, &testData[2], 2));
+
+    source.seek(sizeof(testData) - 2);
+    ASSERT_THROW(source.read(buf, 3), std::runtime_error);
+}
+
+// The read-ahead grows on sequential scans and shrinks on random reads
+TEST_F(PosixSourceTestFixture, AdaptiveWindow) {
+    constexpr int64_t fileSize = 0x100000;
+    std::vector<char> data(fileSize);
+    for(int64_t i = 0; i < fileSize; ++i)
+        data[i] = static_cast<char>(i * 13 + 5);
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        ofs.write(data.data(), fileSize);
+    }
+
+    constexpr int64_t windowSize = 0x1000;
+    BufferedFileSource source(tmpFile, windowSize);
+    char buf[0x100];
+    for(int64_t off = 0; off < fileSize / 2; off += sizeof(buf)) {
+        source.read(buf, sizeof(buf));
+        ASSERT_FALSE(memcmp(buf, &data[off], sizeof(buf)));
+    }
+    auto stats = source.stats();
+    ASSERT_EQ(stats.pattern, AccessHint::Sequential);
+    ASSERT_EQ(stats.fills, stats.sequentialFills);
+    ASSERT_GT(stats.windowSize, 0x10 * windowSize);
+
+    for(const int64_t off : { 0x10, 0xF0000, 0x3000, 0xC0000, 0x8000, 0xE0000 }) {
+        source.seek(off);
+        source.read(buf, sizeof(buf));
+        ASSERT_FALSE(memcmp(buf, &data[off], sizeof(buf)));
+    }
+    stats = source.stats();
+    ASSERT_EQ(stats.pattern, AccessHint::Random);
+    ASSERT_EQ(stats.windowSize, BufferedFileSource::minAdaptiveWindowSize);
+}
+
+// C strings are consumed with reads, which refill the window instead of peeking the file per string
+TEST_F(PosixSourceTestFixture, CStringsRefillWindow) {
+    constexpr int stringCount = 20000;
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        for(int i = 0; i < stringCount; ++i)
+            ofs << "name" << i % 100 << '\0';
+    }
+    const auto fileSize = static_cast<int64_t>(std::filesystem::file_size(tmpFile));
+    const auto maxFills = fileSize / BufferedFileSource::minAdaptiveWindowSize + 1;
+
+    using Source = InstrumentedSource<BufferedFileSource>;
+    auto instrumented = BinaryReader::make<Source>(tmpFile, 0x1000);
+    auto plain = BinaryReader::make<BufferedFileSource>(tmpFile, 0x1000);
+    for(int i = 0; i < stringCount; ++i) {
+        ASSERT_EQ(instrumented.readCString(), "name" + std::to_string(i % 100));
+        ASSERT_EQ(plain.readCString(), "name" + std::to_string(i % 100));
+    }
+
+    const auto metrics = Source::metrics(&instrumented);
+    ASSERT_EQ(metrics.read.calls, stringCount);
+    ASSERT_EQ(metrics.read.bytes, fileSize);
+    const auto instrumentedFills =
+    static_cast<const Source*>(instrumented.getSource())->stats().fills;
+    ASSERT_GT(instrumentedFills, 0);
+    ASSERT_LE(instrumentedFills, maxFills);
+    const auto plainFills =
+    static_cast<const BufferedFileSource*>(plain.getSource())->stats().fills;
+    ASSERT_GT(plainFills, 0);
+    ASSERT_LE(plainFills, maxFills);
+}
+
+TEST_F(PosixSourceTestFixture, InvalidWindowSize) {
+    ASSERT_THROW(BufferedFileSource(tmpFile, 0), std::runtime_error);
+}
+
+#ifdef ZBIO_HAS_IO_URING
+void validateSequentialScan(ISource& source) {
+    char buf[sizeof(testData)]{};
+    int64_t off = 0;
+    for(const int64_t len : { 1, 3, 4, 2, 8, 5, 16, 1, 7, 17 }) {
+        source.peek(buf, len);
+        ASSERT_FALSE(memcmp(buf, &testData[off], len));
+        source.read(buf, len);
+        ASSERT_FALSE(memcmp(buf, &testData[off], len));
+        off += len;
+    }
+
+    // Jump back, out of the read-ahead range
+    source.seek(1);
+    source.read(buf, 9);
+    ASSERT_FALSE(memcmp(buf, &testData[1], 9));
+
+    ASSERT_THROW(source.read(buf, sizeof(testData)), std::runtime_error);
+}
+
+TEST_F(PosixSourceTestFixture, UringFileSourceSmallBlocks) {
+    constexpr int64_t blockSize = 4;
+    constexpr unsigned queueDepth = 4;
+    UringFileSource source(tmpFile, blockSize, queueDepth);
+    validateSequentialScan(source);
+}
+
+// Ring setup fails for queue depths beyond the kernel limit, the source has to fall back.
+// A failed submit must not leave a block waiting for a completion which never arrives
+TEST_F(PosixSourceTestFixture, UringFileSourceSubmitFailure) {
+    constexpr int64_t blockSize = 4;
+    constexpr unsigned queueDepth = 4;
+    UringFileSource source(tmpFile, blockSize, queueDepth);
+    if(!source.usesIoUring())
+        GTEST_SKIP() << "io_uring unavailable";
+
+    using Ring = ZBinaryReader::detail::IoUring;
+    struct RestoreEnter {
+        ~RestoreEnter() { Ring::enter = &Ring::enterSyscall; }
+    } restoreEnter;
+    static int failures;
+    failures = 1;
+    Ring::enter = [](int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        if(toSubmit && failures) {
+            --failures;
+            errno = EAGAIN;
+            return -1L;
+        }
+        return Ring::enterSyscall(ringFd, toSubmit, minComplete, flags);
+    };
+
+    char buf[sizeof(testData)]{};
+    ASSERT_THROW(source.read(buf, 8), std::system_error);
+    source.read(buf, sizeof(buf));
+    ASSERT_FALSE(memcmp(buf, testData, sizeof(testData)));
+}
+
+TEST_F(PosixSourceTestFixture, UringFileSourceFallback) {
+    constexpr int64_t blockSize = 4;
+    constexpr unsigned queueDepth = 1 << 16;
+    UringFileSource source(tmpFile, blockSize, queueDepth);
+    ASSERT_FALSE(source.usesIoUring());
+    validateSequentialScan(source);
+}
+#endif
+
+// Unaligned reads across the blocks of a file with a partial last block
+TEST_F(PosixSourceTestFixture, DirectFileSourceBlocks) {
+    constexpr int64_t fileSize = 3 * DirectFileSource::alignment + 123;
+    std::vector<char> data(fileSize);
+    for(int64_t i = 0; i < fileSize; ++i)
+        data[i] = static_cast<char>(i * 31 + 7);
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        ofs.write(data.data(), fileSize);
+    }
+
+    // Rounded up to a single aligned block
+    DirectFileSource source(tmpFile, 1);
+    ASSERT_EQ(source.size(), fileSize);
+
+    std::vector<char> buf(fileSize);
+    source.seek(DirectFileSource::alignment - 3);
+    source.read(buf.data(), 2 * DirectFileSource::alignment);
+    ASSERT_FALSE(memcmp(buf.data(), &data[DirectFileSource::alignment - 3],
+                        2 * DirectFileSource::alignment));
+
+    for(const int64_t offset : { fileSize - 5, int64_t(17), 2 * DirectFileSource::alignment + 1 }) {
+        source.seek(offset);
+        source.peek(buf.data(), 5);
+        ASSERT_FALSE(memcmp(buf.data(), &data[offset], 5));
+    }
+
+    source.seek(0);
+    source.read(buf.data(), fileSize);
+    ASSERT_FALSE(memcmp(buf.data(), data.data(), fileSize));
+    ASSERT_THROW(source.read(buf.data(), 1), std::runtime_error);
+}
+
+// Stream parsed while a writer thread is still producing it through a pipe
+TEST(StreamSource, Pipe) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    std::thread writer([fd = fds[1]]() {
+        for(size_t off = 0; off < sizeof(testData); off += 3)
+            ASSERT_GT(write(fd, &testData[off], std::min<size_t>(3, sizeof(testData) - off)), 0);
+        close(fd);
+    });
+
+    constexpr int64_t lookback = 8;
+    constexpr int64_t chunkSize = 4;
+    auto br = BinaryReader::make<StreamSource>(fds[0], lookback, chunkSize);
+    ASSERT_EQ(br.size(), -1);
+
+    char buf[sizeof(testData)]{};
+    br.read(buf, 6);
+    ASSERT_EQ(br.peek<int32_t>(), safeCharArrayCast<int32_t>(&testData[6]));
+    br.read(buf + 6, 14);
+    ASSERT_FALSE(memcmp(buf, testData, 20));
+
+    // Back into the lookback window, then skip ahead
+    br.seek(20 - lookback);
+    ASSERT_EQ(br.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[20 - lookback]));
+    br.seek(30);
+    ASSERT_EQ(br.read<int16_t>(), safeCharArrayCast<int16_t>(&testData[30]));
+    ASSERT_THROW(br.seek(10), std::runtime_error);
+
+    br.read(buf, sizeof(testData) - 32);
+    ASSERT_FALSE(memcmp(buf, &testData[32], sizeof(testData) - 32));
+    ASSERT_THROW(ZBIO_UNUSED(br.read<char>()), std::runtime_error);
+
+    writer.join();
+    close(fds[0]);
+}
+
+// Streams of unknown size report the missing contiguous memory, not an out of range read
+TEST(StreamSource, StringViews) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const char data[] = "name";
+    ASSERT_EQ(write(fds[1], data, sizeof(data)), sizeof(data));
+    close(fds[1]);
+
+    auto br = BinaryReader::make<StreamSource>(fds[0]);
+    for(const auto& read : { std::function<void()>([&] { ZBIO_UNUSED(br.readCStringView()); }),
+                             std::function<void()>([&] { ZBIO_UNUSED(br.readStringView(4)); }) }) {
+        try {
+            read();
+            FAIL() << "Expected an exception";
+        } catch(const std::runtime_error& e) {
+            ASSERT_STREQ(e.what(), "Source doesn't expose contiguous memory");
+        }
+    }
+    ASSERT_EQ(br.tell(), 0);
+    ASSERT_EQ(br.readCString(), "name");
+
+    close(fds[0]);
+}
+
+// Cloned readers over a single PreadSource split the file between threads
+TEST_F(PosixSourceTestFixture, PreadSourceConcurrentClones) {
+    constexpr int threadCount = 4;
+    constexpr int64_t chunk = sizeof(testData) / threadCount;
+
+    const auto br = BinaryReader::make<PreadSource>(tmpFile);
+    std::vector<std::vector<char>> results(threadCount, std::vector<char>(chunk));
+    std::vector<std::thread> threads;
+    for(int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i, reader = br.clone()]() mutable {
+            for(int rep = 0; rep < 1000; ++rep) {
+                reader.seek(i * chunk);
+                reader.read(results[i].data(), chunk);
+            }
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+
+    for(int i = 0; i < threadCount; ++i)
+        ASSERT_FALSE(memcmp(results[i].data(), &testData[i * chunk], chunk));
+}
+#endif
+
+// Lengths around the vector widths exercise the SIMD loops and the scalar tail
+template <typename T>
+void validateReverseEndiannessArray() {
+    for(size_t count = 0; count < 70; ++count) {
+        std::vector<T> values(count);
+        for(size_t i = 0; i < count; ++i)
+            memcpy(&values[i], &testData[(i * 3) % (sizeof(testData) - sizeof(T))], sizeof(T));
+
+        auto swapped = values;
+        reverseEndiannessArray(swapped.data(), count);
+        for(size_t i = 0; i < count; ++i) {
+            auto expected = values[i];
+            reverseEndianness(expected);
+            ASSERT_EQ(memcmp(&swapped[i], &expected, sizeof(T)), 0);
+        }
+
+        // Every kernel the CPU supports, not only the one dispatched to
+        for(auto level = 0; level <= static_cast<int>(ZBio::detail::simdLevel()); ++level) {
+            auto kernelSwapped = values;
+            ZBio::detail::byteSwapArray<sizeof(T)>(reinterpret_cast<char*>(kernelSwapped.data()),
+                                                   count,
+                                                   static_cast<ZBio::detail::SimdLevel>(level));
+            for(size_t i = 0; i < count; ++i)
+                ASSERT_EQ(memcmp(&kernelSwapped[i], &swapped[i], sizeof(T)), 0);
+        }
+    }
+}
+
+TEST(Common, ReverseEndiannessArray) {
+    validateReverseEndiannessArray<int16_t>();
+    validateReverseEndiannessArray<uint32_t>();
+    validateReverseEndiannessArray<float>();
+    validateReverseEndiannessArray<int64_t>();
+    validateReverseEndiannessArray<double>();
+}
+
+// Strings spanning several windows, peeked chunks and parts of a concatenation
+TEST(BasicBinaryReader, LongCStrings) {
+    std::string data(1000, 'a');
+    for(size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>('a' + i % 26);
+    data += '\0';
+    data += "bc";
+    data += '\0';
+    data += "unterminated";
+
+    const auto validate = [&](BinaryReader br) {
+        ASSERT_EQ(br.readCString(), data.substr(0, 1000));
+        ASSERT_EQ(br.tell(), 1001);
+        ASSERT_EQ(br.readCString(), "bc");
+        ASSERT_THROW(ZBIO_UNUSED(br.readCString()), std::runtime_error);
+    };
+
+    validate(BinaryReader(data.data(), data.size()));
+    validate(BinaryReader::make<InstrumentedSource<BufferSource>>(data.data(), data.size()));
+    std::vector<std::unique_ptr<ISource>> parts;
+    for(size_t off = 0; off < data.size(); off += 300) {
+        const auto len = std::min<size_t>(300, data.size() - off);
+        parts.push_back(std::make_unique<InstrumentedSource<BufferSource>>(&data[off], len));
+    }
+    validate(BinaryReader::make<ConcatSource>(std::move(parts)));
+}
+
+// Mixins observe C strings as reads of their bytes
+TEST(BasicBinaryReader, CStringsThroughMixins) {
+    const char data[] = "name\0other";
+
+    using Coverage = CoverageTrackingSource<BufferSource>;
+    auto covered = BinaryReader::make<Coverage>(data, sizeof(data));
+    ASSERT_EQ(covered.readCString(), "name");
+    ASSERT_EQ(covered.readCString(), "other");
+    ASSERT_TRUE(Coverage::completeCoverage(&covered));
+    covered.seek(0);
+    ASSERT_THROW(ZBIO_UNUSED(covered.readCString()), std::runtime_error);
+
+    using Recorder = TraceRecordingSource<BufferSource>;
+    auto recording = BinaryReader::make<Recorder>(data, sizeof(data));
+    ZBIO_UNUSED(recording.readCString());
+    ZBIO_UNUSED(recording.readCString());
+    const auto trace = Recorder::trace(&recording);
+    ASSERT_EQ(trace.accesses().size(), 1);
+    ASSERT_EQ(trace.accesses()[0].offset, 0);
+    ASSERT_EQ(trace.accesses()[0].length, sizeof(data));
+
+    using Instrumented = InstrumentedSource<BufferSource>;
+    auto instrumented = BinaryReader::make<Instrumented>(data, sizeof(data));
+    ZBIO_UNUSED(instrumented.readCString());
+    ZBIO_UNUSED(instrumented.readCString());
+    const auto metrics = Instrumented::metrics(&instrumented);
+    ASSERT_EQ(metrics.read.calls, 2);
+    ASSERT_EQ(metrics.read.bytes, sizeof(data));
+    ASSERT_EQ(metrics.seek.calls, 0);
+}
+
+TEST(BasicBinaryReader, StringViews) {
+    const char data[] = "name\0other\0tail";
+    BinaryReader br(data, sizeof(data) - 1);
+    const auto name = br.readCStringView();
+    ASSERT_EQ(name, "name");
+    ASSERT_EQ(name.data(), data);
+    ASSERT_EQ(br.readStringView(5), "other");
+    ASSERT_EQ(br.readCStringView(), "");
+    ASSERT_EQ(br.tell(), 11);
+    ASSERT_THROW(ZBIO_UNUSED(br.readCStringView()), std::runtime_error);
+    ASSERT_THROW(ZBIO_UNUSED(br.readStringView(5)), std::runtime_error);
+    ASSERT_EQ(br.readStringView(4), "tail");
+
+    auto tracked = BinaryReader::make<InstrumentedSource<BufferSource>>(data, sizeof(data));
+    ASSERT_THROW(ZBIO_UNUSED(tracked.readCStringView()), std::runtime_error);
+}
+
+TEST(StringPool, Deduplication) {
+    StringPool pool(true, 0x10);
+    const auto a = pool.intern("texture");
+    const auto b = pool.intern(std::string("texture"));
+    ASSERT_EQ(a, "texture");
+    ASSERT_EQ(a.data(), b.data());
+    ASSERT_EQ(pool.intern(""), "");
+    // Larger than a chunk
+    const std::string longName(0x40, 'x');
+    ASSERT_EQ(pool.intern(longName), longName);
+    ASSERT_EQ(a, "texture");
+
+    auto stats = pool.stats();
+    ASSERT_EQ(stats.strings, 4u);
+    ASSERT_EQ(stats.unique, 3u);
+    ASSERT_EQ(stats.bytes, 7 + 0x40);
+
+    StringPool moved(std::move(pool));
+    ASSERT_EQ(moved.intern("texture").data(), a.data());
+    ASSERT_EQ(pool.stats().strings, 0u);
+
+    StringPool copies(false);
+    ASSERT_NE(copies.intern("a").data(), copies.intern("a").data());
+    ASSERT_EQ(copies.stats().unique, 2u);
+}
+
+TEST(BasicBinaryReader, PooledStrings) {
+    std::string data;
+    for(int i = 0; i < 100; ++i)
+        data += i % 2 ? std::string("mesh") + '\0' : std::string("material") + '\0';
+    data += std::string(600, 'y') + '\0';
+    data += "cba";
+
+    const auto validate = [&](BinaryReader br) {
+        StringPool pool(true, 0x100);
+        std::vector<std::string_view> names;
+        for(int i = 0; i < 100; ++i)
+            names.push_back(br.readCString(pool));
+        ASSERT_EQ(names[0], "material");
+        ASSERT_EQ(names[1], "mesh");
+        ASSERT_EQ(names[98].data(), names[0].data());
+        ASSERT_EQ(names[99].data(), names[1].data());
+        ASSERT_EQ(br.readCString(pool), std::string(600, 'y'));
+        ASSERT_EQ(br.readString<Endianness::LE>(3, pool), "abc");
+        ASSERT_EQ(names[0], "material");
+        ASSERT_EQ(pool.stats().unique, 4u);
+
+        br.seek(0);
+        ASSERT_EQ(br.readString(8, pool).data(), names[0].data());
+    };
+
+    validate(BinaryReader(data.data(), data.size()));
+    std::vector<std::unique_ptr<ISource>> parts;
+    for(size_t off = 0; off < data.size(); off += 250) {
+        const auto len = std::min<size_t>(250, data.size() - off);
+        parts.push_back(std::make_unique<InstrumentedSource<BufferSource>>(&data[off], len));
+    }
+    validate(BinaryReader::make<ConcatSource>(std::move(parts)));
+}
+
+TEST(BasicBinaryReader, ReadStruct) {
+    std::vector<MixedEndianRecord> records;
+    for(int i = 0; i < 100; ++i)
+        records.push_back({ static_cast<uint32_t>(0x01020304 * i), static_cast<uint16_t>(i),
+                            { 'a', static_cast<char>('a' + i % 26) }, i * 0.5,
+                            { i * 1.f, i * 2.f, i * 3.f }, -i });
+
+    // Stored byte order, swapped field by field
+    auto stored = records;
+    for(auto& record : stored) {
+        reverseEndianness(record.id);
+        reverseEndianness(record.flags);
+        reverseEndianness(record.weight);
+        for(auto& p : record.position)
+            reverseEndianness(p);
+    }
+
+    BinaryReader br(reinterpret_cast<const char*>(stored.data()),
+                    stored.size() * sizeof(MixedEndianRecord));
+    const auto first = br.readStruct<MixedEndianRecord>();
+    ASSERT_EQ(memcmp(&first, &records[0], sizeof(first)), 0);
+    std::vector<MixedEndianRecord> rest(records.size() - 1);
+    br.readStruct(rest.data(), rest.size());
+    ASSERT_EQ(memcmp(rest.data(), &records[1], rest.size() * sizeof(MixedEndianRecord)), 0);
+    ASSERT_EQ(rest.back().position[2], 297.f);
+    ASSERT_EQ(rest.back().le, -99);
+}
+
+TEST(BasicBinaryReader, StaticBufferSource) {
+    BasicBinaryReader<BufferSource> br(testData, sizeof(testData));
+    ASSERT_EQ(br.size(), sizeof(testData));
+    ASSERT_EQ(br.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[0]));
+    ASSERT_EQ(br.peek<int16_t>(), safeCharArrayCast<int16_t>(&testData[4]));
+
+    br.seek(0x1C);
+    ASSERT_STREQ(br.readString<4>().c_str(), "Test");
+
+    auto clone = br.clone();
+    ASSERT_EQ(clone.tell(), br.tell());
+    static_assert(std::is_same_v<decltype(br.getSource()), const BufferSource*>);
+}
+
+TEST(BasicBinaryReader, InPlaceSource) {
+    auto br = BasicBinaryReader<BufferSource>::make<BufferSource>(testData, sizeof(testData));
+    ASSERT_EQ(br.read<int32_t>(), safeCharArrayCast<int32_t>(&testData[0]));
+
+    BasicBinaryReader<BufferSource> moved(std::move(br));
+    ASSERT_EQ(moved.tell(), sizeof(int32_t));
+}
+
+TEST(BasicBinaryReader, StaticCoverageTrackingSource) {
+    BasicBinaryReader<CoverageTrackingSource<BufferSource>> br(testData, sizeof(testData));
+    br.sink<char>(sizeof(testData));
+    ASSERT_TRUE(CoverageTrackingSource<BufferSource>::completeCoverage(&br));
+}
+
+TEST(InstrumentedSource, Metrics) {
+    using Source = InstrumentedSource<BufferSource>;
+    auto br = BinaryReader::make<Source>(testData, sizeof(testData));
+
+    ZBIO_UNUSED(br.read<int32_t>());
+    ZBIO_UNUSED(br.peek<int16_t>());
+    br.sink<char>(4);
+    br.seek(2);
+    br.seek(20);
+    ASSERT_THROW(ZBIO_UNUSED(br.readString<sizeof(testData)>()), std::runtime_error);
+
+    const auto metrics = Source::metrics(&br);
+    ASSERT_EQ(metrics.read.calls, 6);
+    ASSERT_EQ(metrics.read.bytes, sizeof(int32_t) + 4);
+    ASSERT_EQ(metrics.peek.calls, 1);
+    ASSERT_EQ(metrics.peek.bytes, sizeof(int16_t));
+    ASSERT_EQ(metrics.seek.calls, 2);
+    ASSERT_EQ(metrics.seek.bytes, 6 + 18);
+    ASSERT_EQ(metrics.backwardSeeks, 1);
+
+    uint64_t histogramCalls = 0;
+    for(const auto count : metrics.read.latency)
+        histogramCalls += count;
+    ASSERT_EQ(histogramCalls, metrics.read.calls);
+
+    BinaryReader plain(testData, sizeof(testData));
+    ASSERT_THROW(ZBIO_UNUSED(Source::metrics(&plain)), std::runtime_error);
+}
+
+// Buffer source logging the ranges it's asked to load
+class AdviseLoggingSource : public BufferSource {
+public:
+    using BufferSource::BufferSource;
+
+    std::vector<std::pair<int64_t, int64_t>> willNeed;
+
+    void advise(int64_t offset, int64_t len, AccessHint hint) noexcept override {
+        if(hint == AccessHint::WillNeed)
+            willNeed.emplace_back(offset, len);
+    }
+};
+
+TEST(AccessTrace, RecordAndReplay) {
+    using Recorder = TraceRecordingSource<BufferSource>;
+    auto recording = BinaryReader::make<Recorder>(testData, sizeof(testData));
+    recording.seek(0x20);
+    ZBIO_UNUSED(recording.read<int32_t>());
+    ZBIO_UNUSED(recording.read<int32_t>()); // Merged with the previous read
+    recording.seek(4);
+    ZBIO_UNUSED(recording.read<int16_t>());
+    recording.seek(0x10);
+    ZBIO_UNUSED(recording.read<int64_t>());
+
+    const auto serialized = Recorder::trace(&recording).serialize();
+    const auto trace = AccessTrace::deserialize(serialized.data(), serialized.size());
+    ASSERT_EQ(trace.sourceSize(), sizeof(testData));
+    ASSERT_EQ(trace.accesses().size(), 3);
+    ASSERT_EQ(trace.accesses()[0].offset, 0x20);
+    ASSERT_EQ(trace.accesses()[0].length, 8);
+    ASSERT_EQ(trace.accesses()[1].offset, 4);
+    ASSERT_EQ(trace.accesses()[2].offset, 0x10);
+    ASSERT_THROW(ZBIO_UNUSED(AccessTrace::deserialize(serialized.data(), serialized.size() - 1)),
+                 std::runtime_error);
+
+    // Hints stay one access ahead with a tiny lookahead, a larger one covers the rest at once.
+    // The replay is driven through a reader over a window lending source.
+    using Replay = TracePrefetchSource<AdviseLoggingSource>;
+    auto source = std::make_unique<Replay>(trace, testData, sizeof(testData));
+    const auto replay = source.get();
+    replay->setLookahead(1);
+    BinaryReader br(std::move(source));
+    br.seek(0x20);
+    ASSERT_EQ(replay->willNeed.size(), 1);
+    ASSERT_EQ(replay->willNeed[0], std::make_pair(int64_t(0x20), int64_t(8)));
+    ZBIO_UNUSED(br.read<int32_t>());
+    ZBIO_UNUSED(br.read<int32_t>());
+    ASSERT_EQ(replay->willNeed.size(), 1);
+    br.seek(4);
+    ASSERT_EQ(replay->willNeed.size(), 2);
+    ASSERT_EQ(replay->willNeed[1], std::make_pair(int64_t(4), int64_t(2)));
+    replay->setLookahead(0x100);
+    ZBIO_UNUSED(br.read<int16_t>());
+    ASSERT_EQ(replay->willNeed.size(), 3);
+    ASSERT_EQ(replay->willNeed[2], std::make_pair(int64_t(0x10), int64_t(8)));
+}
+
 class CoverageTrackingSourceTestFixture : public testing::Test {
 protected:
     void SetUp() override {
@@ -516,6 +1520,76 @@ TEST_F(CoverageTrackingSourceTestFixture, IncompleteCoverage) {
     ASSERT_FALSE(CoverageTrackingSource<BufferSource>::completeCoverage(br.get()));
 }
 
+// Positional reads are tracked once, also when the source emulates them with seek and read
+TEST(CoverageTrackingSource, ReadAt) {
+    using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+    using CTS = CoverageTrackingSource<ConcatSource>;
+    std::vector<std::unique_ptr<ISource>> parts;
+    parts.push_back(std::make_unique<BufferSource>(testData, sizeof(testData)));
+    auto br = BinaryReader::make<CTS>(std::move(parts));
+
+    br.seek(2);
+    ZBIO_UNUSED(br.readAt<int32_t>(8));
+    ZBIO_UNUSED(br.readAt<int16_t>(12));
+    ASSERT_EQ(br.tell(), 2);
+    ASSERT_EQ(CTS::uncoveredRanges(&br), (Ranges{ { 0, 8 }, { 14, sizeof(testData) } }));
+    ASSERT_THROW(ZBIO_UNUSED(br.readAt<char>(9)), std::runtime_error);
+
+#ifdef ZBIO_HAS_POSIX_IO
+    using StreamCTS = CoverageTrackingSource<StreamSource>;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], testData, 16), 16);
+    close(fds[1]);
+    auto stream = BinaryReader::make<StreamCTS>(fds[0]);
+    ZBIO_UNUSED(stream.readAt<int32_t>(4));
+    ASSERT_EQ(stream.tell(), 0);
+    ASSERT_EQ(stream.read<int32_t>(), safeCharArrayCast<int32_t>(testData));
+    close(fds[0]);
+#endif
+}
+
+TEST_F(CoverageTrackingSourceTestFixture, UncoveredRanges) {
+    using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+    using CTS = CoverageTrackingSource<BufferSource>;
+    const int64_t size = sizeof(testData);
+
+    ASSERT_EQ(CTS::uncoveredRanges(br.get()), (Ranges{ { 0, size } }));
+
+    br->seek(4);
+    br->sink<int>();
+    br->seek(16);
+    br->sink<int>(2);
+    ASSERT_EQ(CTS::uncoveredRanges(br.get()), (Ranges{ { 0, 4 }, { 8, 16 }, { 24, size } }));
+
+    // Adjacent reads merge
+    br->seek(8);
+    br->sink<char>(8);
+    br->seek(0);
+    br->sink<int>();
+    ASSERT_EQ(CTS::uncoveredRanges(br.get()), (Ranges{ { 24, size } }));
+    ASSERT_FALSE(CTS::completeCoverage(br.get()));
+
+    br->seek(24);
+    br->sink<char>(size - 24);
+    ASSERT_TRUE(CTS::uncoveredRanges(br.get()).empty());
+    ASSERT_TRUE(CTS::completeCoverage(br.get()));
+}
+
+// Overlap with a range which is neither the first nor the last read one
+TEST_F(CoverageTrackingSourceTestFixture, PartialOverlap) {
+    br->seek(8);
+    br->sink<int>();
+    br->seek(20);
+    br->sink<int>();
+    br->seek(6);
+    ASSERT_THROW(ZBIO_UNUSED(br->read<int>()), std::runtime_error);
+    br->seek(18);
+    ASSERT_THROW(ZBIO_UNUSED(br->read<int>()), std::runtime_error);
+    br->seek(12);
+    br->sink<char>(8);
+}
+
 TEST_F(CoverageTrackingSourceTestFixture, DoubleRead) {
     using T = int;
     ZBIO_UNUSED(br->read<T>());
@@ -523,6 +1597,20 @@ TEST_F(CoverageTrackingSourceTestFixture, DoubleRead) {
     ASSERT_THROW(ZBIO_UNUSED(br->read<T>()), std::runtime_error);
 }
 
+TEST_F(CoverageTrackingSourceTestFixture, Clone) {
+    ASSERT_THROW(ZBIO_UNUSED(br->clone()), std::runtime_error);
+}
+
+TEST_F(CoverageTrackingSourceTestFixture, Slice) {
+    ASSERT_THROW(ZBIO_UNUSED(br->slice(0, 4)), std::runtime_error);
+}
+
+TEST_F(CoverageTrackingSourceTestFixture, View) {
+    const auto view = br->view(sizeof(testData));
+    ASSERT_FALSE(view.isBorrowed());
+    ASSERT_TRUE(CoverageTrackingSource<BufferSource>::completeCoverage(br.get()));
+}
+
 TEST_F(CoverageTrackingSourceTestFixture, DoublePeek) {
     using T = int;
     ZBIO_UNUSED(br->peek<T>());
@@ -4,6 +4,18 @@
 using namespace ZBio;
 using namespace ZBio::ZBinaryWriter;
 
+struct MixedEndianHeader {
+    uint32_t id;
+    uint16_t flags;
+    uint16_t size;
+};
+
+template <>
+struct ZBio::StructLayout<MixedEndianHeader>
+: Layout<Field<&MixedEndianHeader::id, Endianness::BE>,
+         Field<&MixedEndianHeader::flags>,
+         Field<&MixedEndianHeader::size, Endianness::BE>> {};
+
 namespace {
 
 template <typename Source>
@@ -153,6 +165,17 @@ TYPED_TEST(BinaryWriterTest, WriteNonCharArrayBE) {
     ASSERT_TRUE(this->validate(std::vector<char>{ 0x11, 0x22, 0x33, 0x44, 0x12, 0x23, 0x34, 0x45 }));
 }
 
+TYPED_TEST(BinaryWriterTest, WriteStruct) {
+    const MixedEndianHeader headers[] = { { 0x11223344, 0x5566, 0x7712 },
+                                          { 0x01020304, 0x0506, 0x0708 } };
+    this->bw->writeStruct(headers[0]);
+    this->bw->writeStruct(headers, 2);
+    ASSERT_EQ(headers[0].id, 0x11223344u);
+    ASSERT_TRUE(this->validate(std::vector<char>{ 0x11, 0x22, 0x33, 0x44, 0x66, 0x55, 0x77, 0x12,
+                                                  0x11, 0x22, 0x33, 0x44, 0x66, 0x55, 0x77, 0x12,
+                                                  0x01, 0x02, 0x03, 0x04, 0x06, 0x05, 0x07, 0x08 }));
+}
+
 TYPED_TEST(BinaryWriterTest, SeekBackAndOverride) {
     this->bw->seek(4);
     this->bw->template write<char>(0x66);